@@ -8,6 +8,7 @@
 #include <linuxmt/kdev_t.h>
 #include <linuxmt/genhd.h>
 #include <linuxmt/trace.h>
+#include <linuxmt/ktrace.h>
 
 struct request {
     kdev_t rq_dev;              /* block device */
@@ -127,6 +128,7 @@ static void end_request(int uptodate)
 #endif
 
     bh = req->rq_bh;
+    ktrace(uptodate? KT_BDONE: KT_BERROR, req->rq_dev, buffer_blocknr(bh));
     mark_buffer_uptodate(bh, uptodate);
     unlock_buffer(bh);
 
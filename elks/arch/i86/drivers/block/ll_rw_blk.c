@@ -21,6 +21,7 @@
 #include <linuxmt/mm.h>
 #include <linuxmt/ioctl.h>
 #include <linuxmt/debug.h>
+#include <linuxmt/ktrace.h>
 
 #include <arch/system.h>
 #include <arch/io.h>
@@ -230,6 +231,7 @@ static void make_request(unsigned short major, int rw, struct buffer_head *bh)
     req->rq_bh = bh;
     req->rq_errors = 0;
     req->rq_next = NULL;
+    ktrace(rw == READ? KT_BREAD: KT_BWRITE, req->rq_dev, buffer_blocknr(bh));
     add_request(&blk_dev[major], req);
 }
 
@@ -43,6 +43,8 @@
 
 #define MAXPARMS        28
 
+#define MAXRUN          80      /* max chars in one VideoWriteRun */
+
 #ifdef CONFIG_CONSOLE_DUAL
 #define MAX_DISPLAYS    2
 #else
@@ -62,6 +64,8 @@ struct console {
     void (*fsm)(Console *, int);
     unsigned int vseg;          /* vram for this console page */
     unsigned int vseg_offset;   /* vram offset of vseg for this console page */
+    unsigned int vbase_offset;  /* hardware scroll region start, in words */
+    unsigned int vend_offset;   /* hardware scroll region end, 0 if none */
     unsigned short crtc_base;   /* 6845 CRTC base I/O address */
 #ifdef CONFIG_EMUL_ANSI
     int savex, savey;           /* saved cursor position */
@@ -125,6 +129,20 @@ static void VideoWrite(Console * C, int c)
           (C->attr << 8) | (c & 255));
 }
 
+/* write run of printable chars at cursor as one far block write */
+#define VIDEO_WRITE_RUN
+static void VideoWriteRun(Console * C, unsigned char *s, int n)
+{
+    static unsigned short buf[MAXRUN];
+    unsigned int a = C->attr << 8;
+    int i;
+
+    for (i = 0; i < n; i++)
+        buf[i] = a | *s++;
+    fmemcpyw((void *)((C->cx + C->cy * C->Width) << 1), (seg_t) C->vseg,
+             buf, kernel_ds, n);
+}
+
 static void ClearRange(Console * C, int x, int y, int x2, int y2)
 {
     int vp;
@@ -146,6 +164,30 @@ static void ScrollUp(Console * C, int y)
     int MaxRow = C->Height - 1;
     int MaxCol = C->Width - 1;
 
+    /*
+     * Full screen scroll: move CRTC start address down a line within the
+     * console's scroll region, copying the screen back to the region
+     * start only when its end is reached.
+     */
+    if (y == 0 && C->vend_offset) {
+        if (C->vseg_offset + C->Width * (C->Height + 1) <= C->vend_offset) {
+            C->vseg_offset += C->Width;
+            C->vseg += C->Width >> 3;
+        } else {
+            seg_t base = C->vseg - ((C->vseg_offset - C->vbase_offset) >> 3);
+
+            fmemcpyw(0, base, (void *)(C->Width << 1), C->vseg, MaxRow * C->Width);
+            C->vseg_offset = C->vbase_offset;
+            C->vseg = base;
+        }
+        ClearRange(C, 0, MaxRow, MaxCol, MaxRow);
+        if (C == Visible[C->display])
+            SetDisplayPage(C);
+        if (C == Con)
+            VideoSeg = C->vseg;         /* for kernel/timer.c */
+        return;
+    }
+
     vp = y * (C->Width << 1);
     if ((unsigned int)y < MaxRow)
         fmemcpyw((void *)vp, C->vseg,
@@ -204,7 +246,7 @@ void INITPROC console_init(void)
     Console *C = &Con[0];
     int i;
     int Width, Height;
-    unsigned int PageSizeW;
+    unsigned int PageSizeW, RegionW;
     unsigned short boot_crtc;
     unsigned char output_type = OT_EGA;
 
@@ -224,6 +266,15 @@ void INITPROC console_init(void)
             output_type = OT_CGA;
     }
 
+    /*
+     * Split all of text memory between consoles for hardware scrolling,
+     * 16K on CGA and 32K on EGA/VGA. Line length must be a multiple
+     * of 16 bytes, so scrolling a line is a whole number of paragraphs.
+     */
+    RegionW = PageSizeW;
+    if (output_type != OT_MDA && !(Width & 7))
+        RegionW = ((output_type == OT_CGA? 8192U: 16384U) / NumConsoles) & ~7;
+
     Visible[0] = C;
 
     for (i = 0; i < NumConsoles; i++) {
@@ -234,8 +285,11 @@ void INITPROC console_init(void)
             C->cy = peekb(0x51, 0x40);
         }
         C->fsm = std_char;
-        C->vseg_offset = i * PageSizeW;
+        C->vseg_offset = i * RegionW;
         C->vseg = VideoSeg + (C->vseg_offset >> 3);
+        C->vbase_offset = C->vseg_offset;
+        if (RegionW >= Width * (Height + 1))
+            C->vend_offset = C->vseg_offset + RegionW;
         C->attr = A_DEFAULT;
         C->type = output_type;
         C->Width = Width;
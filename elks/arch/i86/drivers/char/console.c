@@ -366,12 +366,60 @@ static int Console_ioctl(struct tty *tty, int cmd, char *arg)
     return -EINVAL;
 }
 
+#ifdef VIDEO_WRITE_RUN
+/*
+ * Write run of printable chars from output queue that fit on the current
+ * line as a single block, returns number of chars written.
+ */
+static int WriteRun(Console * C, struct tty *tty)
+{
+    struct ch_queue *q = &tty->outq;
+    unsigned char *s = q->base + q->tail;
+    int n, max;
+
+    if (C->fsm != std_char || C->XN || tty->ostate)
+        return 0;
+    max = q->size - q->tail;            /* contiguous chars in queue */
+    if (max > q->len)
+        max = q->len;
+    if (max > C->Width - C->cx)
+        max = C->Width - C->cx;
+    if (max > MAXRUN)
+        max = MAXRUN;
+    for (n = 0; n < max && s[n] >= ' '; n++)
+        continue;
+    if (n < 2)
+        return 0;
+
+    VideoWriteRun(C, s, n);
+    if ((q->tail += n) >= q->size)      /* no interrupt access, as tty_outproc */
+        q->tail = 0;
+    q->len -= n;
+
+    C->cx += n;
+    if (C->cx > C->Width - 1) {
+        C->XN = 1;
+        C->cx = C->Width - 1;
+    }
+    return n;
+}
+#endif
+
 static int Console_write(struct tty *tty)
 {
     Console *C = &Con[tty->minor];
     int cnt = 0;
+#ifdef VIDEO_WRITE_RUN
+    int n;
+#endif
 
     while ((tty->outq.len > 0) && !glock) {
+#ifdef VIDEO_WRITE_RUN
+        if ((n = WriteRun(C, tty)) != 0) {
+            cnt += n;
+            continue;
+        }
+#endif
         WriteChar(C, tty_outproc(tty));
         cnt++;
     }
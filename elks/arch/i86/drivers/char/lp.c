@@ -9,19 +9,39 @@
 #ifdef CONFIG_CHAR_DEV_LP
 
 #include <linuxmt/errno.h>
+#include <linuxmt/fcntl.h>
+#include <linuxmt/fs.h>
+#include <linuxmt/ioctl.h>
 #include <linuxmt/kernel.h>
 #include <linuxmt/lp.h>
 #include <linuxmt/mm.h>
+#include <linuxmt/memory.h>
 #include <linuxmt/major.h>
 #include <linuxmt/sched.h>
+#include <linuxmt/timer.h>
 #include <linuxmt/types.h>
 #include <linuxmt/debug.h>
 
 #include <arch/io.h>
+#include <arch/irq.h>
 
+/*
+ * Output is buffered in a far memory ring allocated at open and
+ * drained by the printer ack interrupt, or by a timer when the
+ * port has no usable IRQ, so writers only block when the ring is full.
+ */
 struct lp_info {
     unsigned short io;
     char flags;
+    unsigned char irq;          /* 0 = polled */
+    segment_s *seg;             /* output ring */
+    unsigned int head;          /* next free, writer only */
+    unsigned int tail;          /* next to print, sender only */
+    unsigned int len;           /* chars in ring */
+    jiff_t start;               /* when output became pending */
+    struct wait_queue wait;
+    struct timer_list timer;
+    struct lp_stat stat;
 };
 
 #ifdef BIOS_PORTS
@@ -57,73 +77,174 @@ lp_reset(struct lp_info *lpp)
     LP_CONTROL(LP_SELECT | LP_INIT, lpp);
 }
 
-static int
-lp_char_polled(unsigned char c, struct lp_info *lpp)
+static unsigned char
+lp_control(struct lp_info *lpp)
+{
+    return (lpp->flags & LP_IRQ)? LP_SELECT | LP_INIT | LP_IRQEN: LP_SELECT | LP_INIT;
+}
+
+static void lp_timer(int target);
+
+/* send buffered chars while printer not busy, called with interrupts off */
+static void
+lp_send(struct lp_info *lpp)
+{
+    unsigned char ctl;
+    int n = LP_BURST;
+
+    if (!lpp->len)
+        return;
+    ctl = lp_control(lpp);
+    while (lpp->len && n-- > 0) {
+        if (!(LP_STATUS(lpp) & LP_PBUSY))
+            break;
+        outb(peekb(lpp->tail, lpp->seg->base), lpp->io);
+        /* strobe to latch char, most software impls skip checking ack */
+        LP_CONTROL(ctl | LP_STROBE, lpp);
+        LP_CONTROL(ctl, lpp);
+        lpp->tail = (lpp->tail + 1) & LP_BUFMASK;
+        lpp->len--;
+        lpp->stat.chars++;
+    }
+
+    if (lpp->len == 0)
+        lpp->stat.ticks += jiffies - lpp->start;
+    else if (!(lpp->flags & LP_TIMER)) {
+        /* kick again later in case printer is slow or an ack is lost */
+        lpp->flags |= LP_TIMER;
+        lpp->timer.tl_expires = jiffies +
+            ((lpp->flags & LP_IRQ)? LP_TIME_WAIT: LP_POLL_WAIT);
+        lpp->timer.tl_function = lp_timer;
+        lpp->timer.tl_data = lpp - ports;
+        add_timer(&lpp->timer);
+    }
+    wake_up(&lpp->wait);
+}
+
+static void
+lp_timer(int target)
 {
-    int count = LP_CHAR_WAIT;
-
-    /* write byte to data port first */
-    outb(c, lpp->io);
-
-    /* wait for !busy */
-    do {
-        if (LP_STATUS(lpp) & LP_PBUSY) {
-            /* strobe to latch char */
-            LP_CONTROL(LP_SELECT | LP_INIT | LP_STROBE, lpp);
-            LP_CONTROL(LP_SELECT | LP_INIT, lpp);
-            debug_lp("lp: out %x to %x\n", c, lpp->io);
-            /* most software impls skip checking ack */
-            return 1;
+    struct lp_info *lpp = &ports[target];
+
+    lpp->flags &= ~LP_TIMER;
+    lp_send(lpp);
+}
+
+static void
+lp_irq(int irq, struct pt_regs *regs)
+{
+    struct lp_info *lpp;
+
+    for (lpp = ports; lpp < &ports[LP_PORTS]; lpp++) {
+        if ((lpp->flags & LP_IRQ) && lpp->irq == irq) {
+            lpp->stat.irqs++;
+            lp_send(lpp);
         }
-    } while (count-- > 0);
+    }
+}
+
+/* return error for a stalled printer, or 0 if it is just busy */
+static int
+lp_error(struct lp_info *lpp)
+{
+    int target = lpp - ports;
+    int status = LP_STATUS(lpp);
 
+    if (status & LP_POUTPA) {
+        printk("lp%d out of paper\n", target);
+        lpp->stat.errors++;
+        return -ENOSPC;
+    }
+    if (!(status & LP_PSELECD)) {
+        printk("lp%d off-line\n", target);
+        lpp->stat.errors++;
+        return -EIO;
+    }
+    if (!(status & LP_PERRORP)) {
+        printk("lp%d printer error\n", target);
+        lpp->stat.errors++;
+        return -EFAULT;
+    }
     return 0;
 }
 
 static size_t
 lp_write(struct inode *inode, struct file *file, char *buf, size_t count)
 {
-    jiff_t timeout = jiffies + LP_TIME_WAIT;
-    unsigned short target;
-    struct lp_info *lpp;
-    size_t retval;
+    struct lp_info *lpp = &ports[MINOR(inode->i_rdev)];
     size_t chrsp = 0;
-    int status;
-
-    target = MINOR(inode->i_rdev);
-
-    lpp = &ports[target];
+    unsigned int n;
+    int retval = 0;
 
     while (chrsp < count) {
-        debug_lp("lp%d: write %d/%d\n", target, chrsp, count);
-        if (lp_char_polled(get_user_char((void *)(buf++)), lpp)) {
-            chrsp++;
-            continue;
-        } else {
-            /* printer timed out */
-            status = LP_STATUS(lpp);
-
-            if (status & LP_POUTPA) {
-                printk("lp%d out of paper\n", target);
-                retval = -ENOSPC;
-            } else if (!(status & LP_PSELECD)) {
-                printk("lp%d off-line\n", target);
-                retval = -EIO;
-            } else if (!(status & LP_PERRORP)) {
-                printk("lp%d printer error\n", target);
-                retval = -EFAULT;
-            } else if (timeout >= jiffies) {
-                debug_lp("lp%d: timeout %d<%d\n", target, chrsp, count);
-                retval = 0;
-            } else {
-                continue;
+        debug_lp("lp%d: write %d/%d\n", MINOR(inode->i_rdev), chrsp, count);
+        prepare_to_wait_interruptible(&lpp->wait);
+        if (lpp->len == LP_BUFSIZE) {
+            if (file->f_flags & O_NONBLOCK) {
+                retval = -EAGAIN;
+                break;
             }
-
-            return chrsp ? chrsp : retval;
+            if ((retval = lp_error(lpp)) != 0)
+                break;
+            do_wait();
+            if (current->signal) {
+                retval = -EINTR;
+                break;
+            }
+            finish_wait(&lpp->wait);
+            continue;
         }
-
+        finish_wait(&lpp->wait);
+
+        /* copy up to the end of the free space or the ring, whichever first */
+        n = LP_BUFSIZE - lpp->len;
+        if (n > LP_BUFSIZE - lpp->head)
+            n = LP_BUFSIZE - lpp->head;
+        if (n > count - chrsp)
+            n = count - chrsp;
+        fmemcpyb((char *)lpp->head, lpp->seg->base, buf + chrsp, current->t_regs.ds, n);
+        lpp->head = (lpp->head + n) & LP_BUFMASK;
+        chrsp += n;
+
+        clr_irq();
+        if (lpp->len == 0)
+            lpp->start = jiffies;
+        lpp->len += n;
+        lp_send(lpp);
+        set_irq();
     }
-    return chrsp;
+    finish_wait(&lpp->wait);
+    return chrsp ? chrsp : retval;
+}
+
+static int
+lp_select(struct inode *inode, struct file *file, int sel_type)
+{
+    struct lp_info *lpp = &ports[MINOR(inode->i_rdev)];
+
+    if (sel_type != SEL_OUT)
+        return -EINVAL;
+    if (lpp->len < LP_BUFSIZE)
+        return 1;
+    select_wait(&lpp->wait);
+    return 0;
+}
+
+static int
+lp_ioctl(struct inode *inode, struct file *file, int cmd, char *arg)
+{
+    struct lp_info *lpp = &ports[MINOR(inode->i_rdev)];
+    struct lp_stat stat;
+
+    if (cmd != IOCTL_LP_GETSTAT)
+        return -EINVAL;
+    clr_irq();
+    stat = lpp->stat;
+    if (lpp->len)
+        stat.ticks += jiffies - lpp->start;
+    set_irq();
+    stat.irq = (lpp->flags & LP_IRQ)? lpp->irq: 0;
+    return verified_memcpy_tofs(arg, &stat, sizeof(stat));
 }
 
 static int
@@ -149,22 +270,61 @@ lp_open(struct inode *inode, struct file *file)
         return -EBUSY;
     }
 
+    lpp->seg = seg_alloc(LP_BUFSIZE >> 4, SEG_FLAG_EXTBUF);
+    if (!lpp->seg)
+        return -ENOMEM;
+    lpp->head = lpp->tail = lpp->len = 0;
+
 /*
  * nonexistent port can't be busy
  */
     lpp->flags = LP_EXIST | LP_BUSY;
 
+    /* fall back to timer polling if IRQ unavailable */
+    if (lpp->irq && request_irq(lpp->irq, lp_irq, INT_GENERIC) == 0)
+        lpp->flags |= LP_IRQ;
+    LP_CONTROL(lp_control(lpp), lpp);
+
     return 0;
 }
 
 static void
 lp_release(struct inode *inode, struct file *file)
 {
-    unsigned short target = MINOR(inode->i_rdev);
+    struct lp_info *lpp = &ports[MINOR(inode->i_rdev)];
+
+    /* let the printer finish the job unless interrupted */
+    while (lpp->len && !current->signal) {
+        prepare_to_wait_interruptible(&lpp->wait);
+        if (lpp->len && lp_error(lpp)) {
+            finish_wait(&lpp->wait);
+            break;
+        }
+        if (lpp->len)
+            do_wait();
+        finish_wait(&lpp->wait);
+    }
 
-    ports[target].flags = LP_EXIST;     /* not busy */
+    clr_irq();
+    lpp->len = 0;
+    if (lpp->flags & LP_TIMER)
+        del_timer(&lpp->timer);
+    set_irq();
+    if (lpp->flags & LP_IRQ) {
+        LP_CONTROL(LP_SELECT | LP_INIT, lpp);
+        free_irq(lpp->irq);
+    }
+    seg_free(lpp->seg);
+    lpp->seg = NULL;
 
-    return;
+    lpp->flags = LP_EXIST;     /* not busy */
+}
+
+/* standard IRQ for port address, ack interrupts are not reported by BIOS */
+static unsigned char
+lp_irq_for(unsigned short io)
+{
+    return (io == 0x278)? 5: 7;
 }
 
 #ifndef BIOS_PORTS
@@ -191,8 +351,8 @@ static struct file_operations lp_fops = {
     NULL,                       /* read */
     lp_write,                   /* write */
     NULL,                       /* readdir */
-    NULL,                       /* select */
-    NULL,                       /* ioctl */
+    lp_select,                  /* select */
+    lp_ioctl,                   /* ioctl */
     lp_open,                    /* open */
     lp_release                  /* release */
 };
@@ -213,7 +373,8 @@ lp_init(void)
         /* returns 0 if port wasn't detected by BIOS at bootup */
         if (!lp->io)
             break;              /* there can be no more ports */
-        printk("lp%d at 0x%x, using polling driver\n", i, lp->io);
+        lp->irq = lp_irq_for(lp->io);
+        printk("lp%d at 0x%x, irq %d\n", i, lp->io, lp->irq);
         lp->flags = LP_EXIST;
         lp_reset(lp);
         lp++;
@@ -225,7 +386,8 @@ lp_init(void)
     /* probe for ports */
     for (i = 0; i < LP_PORTS; i++) {
         if (!lp_probe(lp)) {
-            printk("lp%d at 0x%x, using polling driver\n", count, lp->io);
+            lp->irq = lp_irq_for(lp->io);
+            printk("lp%d at 0x%x, irq %d\n", count, lp->io, lp->irq);
             if (count != i)
                 ports[count] = *lp;
             count++;
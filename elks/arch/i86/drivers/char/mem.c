@@ -25,6 +25,7 @@
 #include <linuxmt/heap.h>
 #include <linuxmt/timer.h>
 #include <linuxmt/init.h>
+#include <linuxmt/ktrace.h>
 
 #include <arch/io.h>
 #include <arch/segment.h>
@@ -123,6 +124,11 @@ static int kmem_ioctl(struct inode *inode, struct file *file, int cmd, char *arg
     case MEM_GETSEGALL:
         retword = (unsigned short) &_seg_all;
         break;
+#ifdef CONFIG_KTRACE
+    case MEM_GETKTRACE:
+        retword = (unsigned short) &ktrace_info;
+        break;
+#endif
     case MEM_GETUPTIME:
 #ifdef CONFIG_CPU_USAGE
         retword = (unsigned short) &uptime;
@@ -280,12 +280,74 @@ static void tty_echo(register struct tty *tty, unsigned char ch)
  *
  */
 
+#ifdef CONFIG_CHAR_DEV_RS
+/* queue SLIP character, waiting for room as frame can't be split*/
+static void slip_putc(register struct tty *tty, unsigned char c)
+{
+    while (tty->outq.len == tty->outq.size) {
+        tty->ops->write(tty);
+        chq_wait_wr(&tty->outq, 0);
+    }
+    chq_addch_nowakeup(&tty->outq, c);
+}
+
+/* SLIP line discipline write - send buffer as one escaped frame*/
+static size_t slip_write(register struct tty *tty, char *data, size_t len)
+{
+    size_t i;
+    unsigned char c;
+
+    slip_putc(tty, SLIP_END);
+    for (i = 0; i < len; i++) {
+        c = get_user_char(data++);
+        if (c == SLIP_END) {
+            slip_putc(tty, SLIP_ESC);
+            c = SLIP_ESC_END;
+        } else if (c == SLIP_ESC) {
+            slip_putc(tty, SLIP_ESC);
+            c = SLIP_ESC_ESC;
+        }
+        slip_putc(tty, c);
+    }
+    slip_putc(tty, SLIP_END);
+    tty->ops->write(tty);
+    return len;
+}
+
+/*
+ * SLIP line discipline read - return next frame.
+ * The driver receive interrupt unescapes frames and queues them
+ * preceded by their length, so a frame is never partially present.
+ */
+static size_t slip_read(register struct tty *tty, struct file *file, char *data, size_t len)
+{
+    struct ch_queue *q = &tty->inq;
+    unsigned int size;
+    int n;
+
+    n = chq_wait_rd(q, file->f_flags & O_NONBLOCK);
+    if (n < 0)
+        return n;
+    size = chq_getch(q);
+    size |= chq_getch(q) << 8;
+    n = chq_read(q, data, size < len? size: len);
+    for (size -= n; size; size--)       /* discard rest of frame too large for buffer*/
+        chq_getch(q);
+    return n;
+}
+#endif
+
 size_t tty_write(struct inode *inode, struct file *file, char *data, size_t len)
 {
     register struct tty *tty = determine_tty(inode->i_rdev);
     size_t i;
     int s;
 
+#ifdef CONFIG_CHAR_DEV_RS
+    if (tty->termios.c_line == N_SLIP)
+        return slip_write(tty, data, len);
+#endif
+
     i = 0;
     while (i < len) {
         s = chq_wait_wr(&tty->outq, (file->f_flags & O_NONBLOCK) | i);
@@ -301,8 +363,10 @@ size_t tty_write(struct inode *inode, struct file *file, char *data, size_t len)
                 i = s;
             break;
         }
-        chq_addch_nowakeup(&tty->outq, get_user_char(data++));
-        i++;
+        /* output processing done by driver on removal from outq*/
+        s = chq_write(&tty->outq, data, len - i);
+        data += s;
+        i += s;
     }
     tty->ops->write(tty);
     wake_up(&tty->outq.wait);
@@ -320,6 +384,11 @@ size_t tty_read(struct inode *inode, struct file *file, char *data, size_t len)
     size_t i = 0;
     int ch, k;
 
+#ifdef CONFIG_CHAR_DEV_RS
+    if (tty->termios.c_line == N_SLIP)
+        return slip_read(tty, file, data, len);
+#endif
+
     while (i < len) {
         timeout = jiffies + vtime * (HZ / 10);
 again:
@@ -390,6 +459,7 @@ int tty_ioctl(struct inode *inode, struct file *file, int cmd, char *arg)
 {
     register struct tty *tty = determine_tty(inode->i_rdev);
     int ret, dev;
+    unsigned char line;
 
     switch (cmd) {
     case TCGETS:
@@ -398,7 +468,9 @@ int tty_ioctl(struct inode *inode, struct file *file, int cmd, char *arg)
     case TCSETS:
     case TCSETSW:
     case TCSETSF:
+        line = tty->termios.c_line;     /* only changed by TIOCSETD*/
         ret = verified_memcpy_fromfs(&tty->termios, arg, sizeof(struct termios));
+        tty->termios.c_line = line;
 
         /* Inform subdriver of new settings*/
         if (ret == 0 && tty->ops->ioctl != NULL)
@@ -94,8 +94,15 @@ size_t pty_read (struct inode *inode, struct file *file, char *data, size_t len)
 			break;
 		}
 
-		put_user_char (tty_outproc (tty), (void *)(data++));
-		count++;
+		/* copy directly when no output processing pending*/
+		if (!(tty->termios.c_oflag & OPOST) && !tty->ostate)
+			err = chq_read (&tty->outq, data, len - count);
+		else {
+			put_user_char (tty_outproc (tty), (void *)data);
+			err = 1;
+		}
+		data += err;
+		count += err;
 	}
 
 	if (count > 0)
@@ -120,6 +127,14 @@ size_t pty_write (struct inode *inode, struct file *file, char *data, size_t len
 			break;
 		}
 
+		/* copy directly when no signal characters to check*/
+		if (!(tty->termios.c_lflag & ISIG) || !tty->pgrp) {
+			ret = chq_write (&tty->inq, data, len - count);
+			data += ret;
+			count += ret;
+			continue;
+		}
+
 		ret = get_user_char ((void *)(data++));
 		if (!tty_intcheck(tty, ret))
 			chq_addch_nowakeup (&tty->inq, ret);
@@ -28,12 +28,23 @@ struct serial_info {
     unsigned char mcr;
     unsigned int  divisor;
     struct tty *tty;
-    int pad1, pad2, pad3;       // round out to 16 bytes for faster addressing of ports[]
+    unsigned char fcr;          /* FIFO control, sets receive trigger level */
+    unsigned char ier;          /* interrupts enabled */
+    unsigned char txfifo;       /* bytes to send per THRE interrupt */
+    unsigned char slipesc;      /* SLIP line discipline: last char was ESC */
+    unsigned long rx_chars;     /* stats */
+    unsigned long tx_chars;
+    unsigned int  overruns;
+    unsigned int  rx_dropped;
+    unsigned int  errors;
+    int slipflen;               /* SLIP frame length received, -1 dropping */
+    int pad3;                   // round out to 32 bytes for faster addressing of ports[]
 };
 
 /* flags*/
 #define SERF_TYPE       15
 #define SERF_EXIST      16
+#define SERF_TXIRQ      32      /* interrupt driven transmit */
 #define ST_8250         0
 #define ST_16450        1
 #define ST_16550        2
@@ -52,11 +63,15 @@ struct serial_info {
 #define DEFAULT_MCR             \
         ((unsigned char) (UART_MCR_DTR | UART_MCR_RTS | UART_MCR_OUT2))
 
+#define DEFAULT_FCR             UART_FCR_ENABLE_FIFO14
+
+#define FIFO_SIZE               16      /* 16550A transmit FIFO */
+
 static struct serial_info ports[NR_SERIAL] = {
-    {(char *)COM1_PORT, COM1_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, 0,0,0},
-    {(char *)COM2_PORT, COM2_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, 0,0,0},
-    {(char *)COM3_PORT, COM3_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, 0,0,0},
-    {(char *)COM4_PORT, COM4_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, 0,0,0},
+    {(char *)COM1_PORT, COM1_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, DEFAULT_FCR},
+    {(char *)COM2_PORT, COM2_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, DEFAULT_FCR},
+    {(char *)COM3_PORT, COM3_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, DEFAULT_FCR},
+    {(char *)COM4_PORT, COM4_IRQ, 0, DEFAULT_LCR, DEFAULT_MCR, 0, NULL, DEFAULT_FCR},
 };
 
 static char irq_to_port[16];
@@ -188,12 +203,46 @@ static void update_port(register struct serial_info *port)
     }
 }
 
-/* serial write - busy loops until transmit buffer available */
+/*
+ * Send up to a FIFO full from the output queue if transmitter empty,
+ * then enable the THRE interrupt only while more remains to be sent.
+ * Called with interrupts disabled.
+ */
+static void rs_xmit(register struct serial_info *sp)
+{
+    struct tty *tty = sp->tty;
+    unsigned char ier;
+    int n;
+
+    if (INB(sp->io + UART_LSR) & UART_LSR_THRE) {
+        n = sp->txfifo;
+        while (tty->outq.len > 0 && n--) {
+            OUTB((char)tty_outproc(tty), sp->io + UART_TX);
+            sp->tx_chars++;
+        }
+    }
+    ier = tty->outq.len? UART_IER_RDI | UART_IER_THRI: UART_IER_RDI;
+    if (ier != sp->ier) {
+        sp->ier = ier;
+        OUTB(ier, sp->io + UART_IER);
+    }
+}
+
+/* serial write - start interrupt driven transmit, else busy loop */
 static int rs_write(struct tty *tty)
 {
     register struct serial_info *port = &ports[tty->minor - RS_MINOR_OFFSET];
     int i = 0;
 
+    if (port->flags & SERF_TXIRQ) {
+        i = tty->outq.len;
+        clr_irq();
+        if (!(port->ier & UART_IER_THRI))       /* else already running */
+            rs_xmit(port);
+        set_irq();
+        return i;
+    }
+
     while (tty->outq.len > 0) {
         /* Wait until transmitter hold buffer empty */
         while (!(INB(port->io + UART_LSR) & UART_LSR_THRE))
@@ -279,36 +328,97 @@ void fast_com2_irq(void)
 
 #if !defined(CONFIG_FAST_IRQ4) || !defined(CONFIG_FAST_IRQ3)
 
+/*
+ * SLIP line discipline receive. Unescaped frame data is stored past the
+ * queue head, leaving room for a length word, and only added to the
+ * queue when the closing END is seen.
+ */
+static void slip_rxchar(register struct serial_info *sp, struct ch_queue *q, unsigned char c)
+{
+    int i;
+
+    if (sp->slipesc) {
+        sp->slipesc = 0;
+        if (c == SLIP_ESC_END)
+            c = SLIP_END;
+        else if (c == SLIP_ESC_ESC)
+            c = SLIP_ESC;
+    } else if (c == SLIP_ESC) {
+        sp->slipesc = 1;
+        return;
+    } else if (c == SLIP_END) {
+        if (sp->slipflen > 0) {
+            q->base[q->head] = (unsigned char)sp->slipflen;
+            i = q->head + 1;
+            if (i >= q->size)
+                i = 0;
+            q->base[i] = sp->slipflen >> 8;
+            q->head += sp->slipflen + 2;
+            if (q->head >= q->size)
+                q->head -= q->size;
+            q->len += sp->slipflen + 2;
+        }
+        sp->slipflen = 0;
+        return;
+    }
+
+    if (sp->slipflen < 0)
+        return;
+    if (q->len + sp->slipflen + 2 >= q->size) {
+        sp->rx_dropped++;
+        sp->slipflen = -1;              /* drop frame until next END */
+        return;
+    }
+    i = q->head + sp->slipflen + 2;
+    if (i >= q->size)
+        i -= q->size;
+    q->base[i] = c;
+    sp->slipflen++;
+}
+
 /*
  * Slower serial interrupt routine, called from _irq_com with passed irq #
- * Reads all FIFO data available per interrupt and can provide serial stats
+ * Reads all FIFO data available per interrupt, refills transmit FIFO
+ * and keeps serial stats
  */
 void rs_irq(int irq, struct pt_regs *regs)
 {
     struct serial_info *sp = &ports[(int)irq_to_port[irq]];
     char *io = sp->io;
     struct ch_queue *q = &sp->tty->inq;
+    int status;
 
-    int status = INB(io + UART_LSR);                    /* check for data overrun*/
-    if ((status & UART_LSR_DR) == 0)                    /* QEMU may interrupt w/no data*/
-        return;
-
-#if UNUSED      // turn on for serial stats
-    if (status & UART_LSR_OE)
-        printk("serial: data overrun\n");
-    if (status & (UART_LSR_FE|UART_LSR_PE))
-        printk("serial: frame/parity error\n");
-#endif
-
-    /* read uart/fifo until empty*/
+    /* loop until no interrupt pending, as PIC is edge triggered*/
     do {
-        unsigned char c = INB(io + UART_RX);            /* Read received data */
-        if (!tty_intcheck(sp->tty, c))
-            chq_addch_nowakeup(q, c);
-    } while (INB(io + UART_LSR) & UART_LSR_DR); /* while data available (for FIFOs)*/
+        status = INB(io + UART_LSR);
+        if (status & UART_LSR_DR) {             /* QEMU may interrupt w/no data*/
+            if (status & UART_LSR_OE)
+                sp->overruns++;
+            if (status & (UART_LSR_FE|UART_LSR_PE))
+                sp->errors++;
+
+            /* read uart/fifo until empty*/
+            do {
+                unsigned char c = INB(io + UART_RX);    /* Read received data */
+                sp->rx_chars++;
+                if (sp->tty->termios.c_line == N_SLIP)
+                    slip_rxchar(sp, q, c);
+                else if (!tty_intcheck(sp->tty, c)) {
+                    if (q->len < q->size)
+                        chq_addch_nowakeup(q, c);
+                    else sp->rx_dropped++;
+                }
+            } while (INB(io + UART_LSR) & UART_LSR_DR); /* while data available (for FIFOs)*/
+
+            if (q->len)         /* don't wakeup unless chars else EINTR result*/
+                wake_up(&q->wait);
+        }
 
-    if (q->len)         /* don't wakeup unless chars else EINTR result*/
-        wake_up(&q->wait);
+        if ((status & UART_LSR_THRE) && (sp->ier & UART_IER_THRI)) {
+            rs_xmit(sp);
+            wake_up(&sp->tty->outq.wait);
+        }
+    } while (!(INB(io + UART_IIR) & UART_IIR_NO_INT));
 }
 
 #endif  // !defined(CONFIG_FAST_IRQ4) || !defined(CONFIG_FAST_IRQ3)
@@ -320,6 +430,18 @@ static void rs_release(struct tty *tty)
 
     debug_tty("SERIAL close %P\n");
     if (--tty->usecount == 0) {
+        /* let interrupt driven output drain*/
+        while (tty->outq.len && (port->flags & SERF_TXIRQ)) {
+            prepare_to_wait_interruptible(&tty->outq.wait);
+            if (tty->outq.len)
+                do_wait();
+            finish_wait(&tty->outq.wait);
+            if (current->signal)
+                break;
+        }
+        port->flags &= ~SERF_TXIRQ;
+        port->ier = 0;
+        tty->termios.c_line = N_TTY;
         OUTB(0, port->io + UART_IER);   /* Disable all interrupts */
         free_irq(port->irq);
         tty_freeq(tty);
@@ -353,6 +475,8 @@ static int rs_open(struct tty *tty)
 #endif
     default:
         err = request_irq(port->irq, rs_irq, INT_GENERIC);
+        if (!err)
+            port->flags |= SERF_TXIRQ;  /* fast handlers are receive only */
         break;
     }
     if (err) goto errout;
@@ -369,9 +493,12 @@ errout:
     INB(port->io + UART_LSR);
 
     /* enable FIFO and flush input*/
+    port->txfifo = 1;
 #ifdef CONFIG_HW_SERIAL_FIFO
-    if ((port->flags & SERF_TYPE) > ST_16550)
-        OUTB(UART_FCR_ENABLE_FIFO14, port->io + UART_FCR);
+    if ((port->flags & SERF_TYPE) > ST_16550) {
+        OUTB(port->fcr | UART_FCR_CLEAR_RCVR | UART_FCR_CLEAR_XMIT, port->io + UART_FCR);
+        port->txfifo = FIFO_SIZE;
+    }
 #else
     /* flush input*/
     flush_input(port);
@@ -384,6 +511,7 @@ errout:
     update_port(port);
 
     /* enable receiver data interrupt*/
+    port->ier = UART_IER_RDI;
     OUTB(UART_IER_RDI, port->io + UART_IER);
 
     OUTB(port->mcr, port->io + UART_MCR);
@@ -397,39 +525,52 @@ errout:
     return 0;
 }
 
-#if UNUSED      // removed for bloat
-static int set_serial_info(struct serial_info *info,
-                           struct serial_info *new_info)
+static const unsigned char triggers[4] = { 1, 4, 8, 14 };
+
+/* set receive FIFO trigger level, other fields are read only */
+static int set_serial_info(struct serial_info *sp, struct serial_struct *arg)
 {
-    register struct tty *tty;
-    int err;
+    struct serial_struct ss;
+    int i, err;
 
-    tty = info->tty;
-    err = verified_memcpy_fromfs(info, new_info, sizeof(struct serial_info));
-    if (!err) {
-        /* shutdown serial port and restart UART with new settings */
-
-        /* witty cheat :) - either we do this (and waste some DS) or duplicate
-         * almost whole rs_release and rs_open (and waste much more CS)
-         */
-        info->tty = tty;
-        rs_release(tty);
-        err = rs_open(tty);
+    err = verified_memcpy_fromfs(&ss, arg, sizeof(ss));
+    if (err)
+        return err;
+    for (i = 0; i < 4; i++) {
+        if (ss.rx_trigger == triggers[i]) {
+            sp->fcr = (sp->fcr & ~UART_FCR_TRIGGER_MASK) | (i << 6);
+#ifdef CONFIG_HW_SERIAL_FIFO
+            if (sp->tty->usecount && (sp->flags & SERF_TYPE) > ST_16550)
+                OUTB(sp->fcr & ~(UART_FCR_CLEAR_RCVR|UART_FCR_CLEAR_XMIT), sp->io + UART_FCR);
+#endif
+            return 0;
+        }
     }
-    return err;
+    return -EINVAL;
 }
 
-static int get_serial_info(struct serial_info *info,
-                           struct serial_info *ret_info)
+static int get_serial_info(struct serial_info *sp, struct serial_struct *arg)
 {
-    return verified_memcpy_tofs(ret_info, info, sizeof(struct serial_info));
+    struct serial_struct ss;
+
+    ss.type = sp->flags & SERF_TYPE;
+    ss.rx_trigger = triggers[(sp->fcr & UART_FCR_TRIGGER_MASK) >> 6];
+    ss.tx_fifo = (sp->flags & SERF_TXIRQ)? sp->txfifo: 0;
+    clr_irq();
+    ss.rx_chars = sp->rx_chars;
+    ss.tx_chars = sp->tx_chars;
+    ss.overruns = sp->overruns;
+    ss.rx_dropped = sp->rx_dropped;
+    ss.errors = sp->errors;
+    set_irq();
+    return verified_memcpy_tofs(arg, &ss, sizeof(ss));
 }
-#endif
 
 static int rs_ioctl(struct tty *tty, int cmd, char *arg)
 {
     register struct serial_info *port = &ports[tty->minor - RS_MINOR_OFFSET];
     int retval = 0;
+    int ldisc;
 
     /* few sanity checks should be here */
     debug("rs_ioctl: sp = %d, cmd = %d\n", tty->minor - RS_MINOR_OFFSET, cmd);
@@ -441,14 +582,33 @@ static int rs_ioctl(struct tty *tty, int cmd, char *arg)
         //FIXME: update_port() only sets baud rate from termios, not parity or wordlen*/
         update_port(port);      /* ignored return value*/
         break;
-#if UNUSED
     case TIOCSSERIAL:
-        retval = set_serial_info(port, (struct serial_info *)arg);
+        retval = set_serial_info(port, (struct serial_struct *)arg);
         break;
 
     case TIOCGSERIAL:
-        retval = get_serial_info(port, (struct serial_info *)arg);
-#endif
+        retval = get_serial_info(port, (struct serial_struct *)arg);
+        break;
+
+    case TIOCSETD:
+        retval = verified_memcpy_fromfs(&ldisc, arg, sizeof(ldisc));
+        if (retval)
+            break;
+        /* SLIP framing done in rs_irq, not in fast receive handlers */
+        if (ldisc != N_TTY && (ldisc != N_SLIP || !(port->flags & SERF_TXIRQ)))
+            return -EINVAL;
+        clr_irq();
+        tty->termios.c_line = ldisc;
+        port->slipesc = 0;
+        port->slipflen = 0;
+        tty->inq.len = tty->inq.head = tty->inq.tail = 0;
+        set_irq();
+        break;
+
+    case TIOCGETD:
+        ldisc = tty->termios.c_line;
+        retval = verified_memcpy_tofs(arg, &ldisc, sizeof(ldisc));
+        break;
 
     default:
         return -EINVAL;
@@ -15,6 +15,7 @@
 #include <linuxmt/major.h>
 #include <linuxmt/fcntl.h>
 #include <linuxmt/mm.h>
+#include <linuxmt/string.h>
 #include <linuxmt/tcpdev.h>
 #include <linuxmt/debug.h>
 
@@ -22,26 +23,43 @@
 
 #ifdef CONFIG_INET
 
+/*
+ * Messages in both directions are batched: each tdb_* message is preceded
+ * by a tdb_len_t length, and a single read or write on /dev/tcpdev carries
+ * as many of them as fit. Commands from the socket layer are appended to
+ * tdout_buf until ktcp reads the whole batch. Replies from ktcp are
+ * dispatched one at a time through tdin_buf; only a data-carrying TDT_READ
+ * keeps bufin_sem held until the reading process has copied the data out.
+ */
 unsigned char tdin_buf[TCPDEV_INBUFFERSIZE];    /* for reading tcpdev*/
 unsigned char tdout_buf[TCPDEV_OUTBUFFERSIZE];  /* for writing tcpdev*/
 
-sem_t bufin_sem, bufout_sem;    /* Buffer semaphores */
+sem_t bufin_sem;                /* Buffer semaphore */
 
-static unsigned int tdin_tail, tdout_tail;
+static unsigned int tdout_tail; /* end of queued commands in tdout_buf*/
+static unsigned int tdout_resv; /* end of space reserved by get_tdout_buf*/
 
 static struct wait_queue tcpdevq;
+static struct wait_queue tdoutq;
 
 char tcpdev_inuse;
 
-char *get_tdout_buf(void)
+/* reserve len bytes in tdout_buf for a command, sleeping while it's full*/
+char *get_tdout_buf(unsigned int len)
 {
-    down(&bufout_sem);
-    return (char *)tdout_buf;
+    while (tdout_tail + sizeof(tdb_len_t) + len > TCPDEV_OUTBUFFERSIZE) {
+        debug_net("TCPDEV(%P) outbuf full %u\n", tdout_tail);
+        sleep_on(&tdoutq);
+    }
+    tdout_resv = tdout_tail + sizeof(tdb_len_t) + len;
+    return (char *)&tdout_buf[tdout_tail + sizeof(tdb_len_t)];
 }
 
 static size_t tcpdev_read(struct inode *inode, struct file *filp, char *data,
                        unsigned int len)
 {
+    unsigned int n, msglen;
+
     debug("TCPDEV(%P) read %u\n", len);
 
     while (tdout_tail == 0) {
@@ -54,33 +72,38 @@ static size_t tcpdev_read(struct inode *inode, struct file *filp, char *data,
         }
     }
 
-    /*
-     *  If the userspace tcpip stack requests less data than what is in the
-     *  buffer it will lose data, so the tcpip stack should read BIG.
-     */
-    if (len < tdout_tail)
+    /* return as many whole messages as fit, the tcpip stack should read BIG */
+    for (n = 0; n < tdout_tail; n += msglen) {
+        msglen = *(tdb_len_t *)&tdout_buf[n] + sizeof(tdb_len_t);
+        if (n + msglen > len)
+            break;
+    }
+    if (n == 0) {
         debug_net("TCPDEV(%P) read len too small %u\n", len);
-    else len = tdout_tail;
-    memcpy_tofs(data, tdout_buf, len);
-    tdout_tail = 0;
-    up(&bufout_sem);
-
-    debug("TCPDEV(%P) read retval %u bufout_sem %d\n", len, bufout_sem);
-    //if (bufout_sem > 0)
-        //panic("bufout_sem tragedy");
-    return len;
+        return -EINVAL;
+    }
+    memcpy_tofs(data, tdout_buf, n);
+    tdout_tail -= n;
+    if (tdout_tail)
+        memmove(tdout_buf, &tdout_buf[n], tdout_tail);
+    wake_up(&tdoutq);
+
+    debug("TCPDEV(%P) read retval %u\n", n);
+    return n;
 }
 
+/* queue command previously built in get_tdout_buf space*/
 int tcpdev_inetwrite(void *data, unsigned int len)
 {
     debug("TCPDEV(%P) inetwrite %u\n", len);
-    if (len > TCPDEV_OUTBUFFERSIZE) {
+    if (tdout_tail + sizeof(tdb_len_t) + len > tdout_resv) {
         debug_net("TCPDEV(%P) inetwrite len too large %u\n", len);
         return -EINVAL;
     }
 
     /* Data already in tdout_buf buffer */
-    tdout_tail = len;
+    *(tdb_len_t *)&tdout_buf[tdout_tail] = len;
+    tdout_tail += sizeof(tdb_len_t) + len;
     wake_up(&tcpdevq);
     return 0;
 }
@@ -93,19 +116,28 @@ void tcpdev_clear_data_avail(void)
 static size_t tcpdev_write(struct inode *inode, struct file *filp,
                         char *data, size_t len)
 {
+    size_t count = len;
+    unsigned int msglen;
+
     debug("TCPDEV(%P) write %u\n", len);
-    if (len > TCPDEV_INBUFFERSIZE) {
-        debug_net("TCPDEV(%P) write len too large %u\n", len);
-        return -EINVAL;
-    }
-    if (len > 0) {
-        down(&bufin_sem);
+    while (count >= sizeof(tdb_len_t)) {
+        msglen = get_user(data);
+        data += sizeof(tdb_len_t);
+        count -= sizeof(tdb_len_t);
+        if (msglen > count || msglen > TCPDEV_INBUFFERSIZE) {
+            debug_net("TCPDEV(%P) write bad message len %u\n", msglen);
+            return -EINVAL;
+        }
+        if (msglen > 0) {
+            down(&bufin_sem);
 
-        tdin_tail = (unsigned) len;
-        memcpy_fromfs(tdin_buf, data, len);
+            memcpy_fromfs(tdin_buf, data, msglen);
 
-        /* Call the af_inet code to handle the data */
-        inet_process_tcpdev((char *)tdin_buf, len);
+            /* Call the af_inet code to handle the data */
+            inet_process_tcpdev((char *)tdin_buf, msglen);
+        }
+        data += msglen;
+        count -= msglen;
     }
     debug("TCPDEV(%P) write retval %u\n", len);
     return len;
@@ -148,7 +180,7 @@ static int tcpdev_open(struct inode *inode, struct file *file)
         debug_net("TCPDEV open retval -EBUSY\n");
         return -EBUSY;
     }
-    tdin_tail = tdout_tail = 0;
+    tdout_tail = tdout_resv = 0;
     tcpdev_inuse = 1;
     return 0;
 }
@@ -173,7 +205,7 @@ static struct file_operations tcpdev_fops = {
 void INITPROC tcpdev_init(void)
 {
     register_chrdev(TCPDEV_MAJOR, "tcpdev", &tcpdev_fops);
-    bufin_sem = bufout_sem = 0;
+    bufin_sem = 0;
     tcpdev_inuse = 0;
 }
 
@@ -27,6 +27,7 @@
 #include <linuxmt/mm.h>  
 #include <linuxmt/debug.h> 
 #include <linuxmt/netstat.h>
+#include <linuxmt/ktrace.h>
 #include <netinet/in.h>
 #include "eth-msgs.h"
 
@@ -316,6 +317,7 @@ static size_t el3_write(struct inode *inode, struct file *file, char *data, size
 			//el3_mdelay(1);		// Wait - for now, to avoid collision
 
 		res = len;
+		ktrace(KT_NETTX, len, 0);
 		outw(SetIntrEnb | active_imask, ioaddr + EL3_CMD);	// Reenable interrupts
 		break;
 	}
@@ -570,7 +572,7 @@ static size_t el3_read(struct inode *inode, struct file *filp, char *data, size_
 
 			outw(RxDiscard, ioaddr + EL3_CMD); /* Pop top Rx packet. */
 			res = pkt_len;
-			
+			ktrace(KT_NETRX, pkt_len, 0);
 		}
 		break;
 	}
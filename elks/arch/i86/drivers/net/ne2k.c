@@ -20,6 +20,7 @@
 #include <linuxmt/string.h>
 #include <linuxmt/debug.h>
 #include <linuxmt/netstat.h>
+#include <linuxmt/ktrace.h>
 #include <arch/io.h>
 #include <arch/irq.h>
 #include "eth-msgs.h"
@@ -40,6 +41,7 @@ int net_port;	    /* required for ne2k-asm.S */
 
 static unsigned char usecount;
 static unsigned char found;
+static unsigned char rx_batch;	/* return multiple packets per read */
 static unsigned int verbose;
 static struct wait_queue rxwait;
 static struct wait_queue txwait;
@@ -53,72 +55,106 @@ extern word_t ne2k_has_data;
 extern struct eth eths[];
 
 /*
- * Read a complete packet from the NIC buffer
+ * Get one packet from the NIC buffer into user space
  */
 
-static size_t ne2k_read(struct inode *inode, struct file *filp, char *data, size_t len)
+static int ne2k_get_packet(char *data, size_t len)
 {
-	size_t res;
+	size_t size;	/* actual packet size */
 	word_t nhdr[2];	/* buffer header from the NIC, for debugging */
 
-	while (1) {
-		size_t size;  // actual packet size
+	size = ne2k_pack_get(data, len, nhdr);
 
-		//printk("R");
-		prepare_to_wait_interruptible(&rxwait);
-		if (!ne2k_has_data) {
-		//if (ne2k_rx_stat() != NE2K_STAT_RX) {
+	//printk("r%04x|%04x/",nhdr[0], nhdr[1]);	// NIC buffer header
+	debug_eth("ne0: read: req %d, got %d real %d\n", len, size, nhdr[1]);
 
-			if (filp->f_flags & O_NONBLOCK) {
-				res = -EAGAIN;
-				break;
-			}
-			do_wait();
-			if (current->signal) {
-				res = -EINTR;
-				break;
-			}
-		}
-		size = ne2k_pack_get(data, len, nhdr);
-
-		//printk("r%04x|%04x/",nhdr[0], nhdr[1]);	// NIC buffer header
-		debug_eth("ne0: read: req %d, got %d real %d\n", len, size, nhdr[1]);
-
-		//if ((nhdr[1] > size) || (nhdr[0] == 0)) {
-		if ((nhdr[0]&~0x7f21) || (nhdr[0] == 0)) {	//EXPERIMENTAL: Upper byte = block #, max 7f
-
-			/* Sanity check, should not happen.
-			 * If this happens, we're reading garbage from the NIC, all pointers
-			 * may be invalid, clear device and buffers.
-			 *	
-			 * Likely reason: We have a 8 bit interface running with 16k buffer enabled.
-			 * 
-			 * May want to add more tests for nhdr[0]:
-			 * 	Low byte should be 1 or 21	(receive status reg)
-			 *	High byte is a pointer to the next packet in the NIC ring buffer,
-			 *		should be < 0x80 and > 0x45
-			 */
-
-			netif_stat.rq_errors++;
-			printk("$%04x.%02x$", ne2k_getpage(), ne2k_next_pk&0xff);
-			if (verbose) printk(EMSG_DMGPKT, dev_name, nhdr[0], nhdr[1]);
+	//if ((nhdr[1] > size) || (nhdr[0] == 0)) {
+	if ((nhdr[0]&~0x7f21) || (nhdr[0] == 0)) {	//EXPERIMENTAL: Upper byte = block #, max 7f
+
+		/* Sanity check, should not happen.
+		 * If this happens, we're reading garbage from the NIC, all pointers
+		 * may be invalid, clear device and buffers.
+		 *	
+		 * Likely reason: We have a 8 bit interface running with 16k buffer enabled.
+		 * 
+		 * May want to add more tests for nhdr[0]:
+		 * 	Low byte should be 1 or 21	(receive status reg)
+		 *	High byte is a pointer to the next packet in the NIC ring buffer,
+		 *		should be < 0x80 and > 0x45
+		 */
+
+		netif_stat.rq_errors++;
+		printk("$%04x.%02x$", ne2k_getpage(), ne2k_next_pk&0xff);
+		if (verbose) printk(EMSG_DMGPKT, dev_name, nhdr[0], nhdr[1]);
 
 #if 0
-			if (nhdr[0] == 0) { 	// When this happens, the NIC has serious trouble,
-						// need to reset as if we had a buffer overflow.
-				res = ne2k_clr_oflow(0); 
-				//printk("<%04x>", res);
-			} else
+		if (nhdr[0] == 0) { 	// When this happens, the NIC has serious trouble,
+					// need to reset as if we had a buffer overflow.
+			res = ne2k_clr_oflow(0); 
+			//printk("<%04x>", res);
+		} else
 #endif
-				ne2k_rx_init();	// Resets the ring buffer pointers to initial values,
-						// effectively purging the buffer.
-			res = -EIO;
-			break;
+			ne2k_rx_init();	// Resets the ring buffer pointers to initial values,
+					// effectively purging the buffer.
+		return -EIO;
+	}
+	netif_stat.rx_packets++;
+	ktrace(KT_NETRX, size, 0);
+	return size;
+}
+
+/*
+ * Read a complete packet from the NIC buffer.
+ * In batch mode (IOCTL_ETH_RXBATCH_SET), return as many packets as are
+ * waiting and fit, each preceded by its length word, saving a system
+ * call and a select wakeup per packet under load.
+ */
+
+static size_t ne2k_read(struct inode *inode, struct file *filp, char *data, size_t len)
+{
+	int size;
+	size_t res = 0;
+
+	prepare_to_wait_interruptible(&rxwait);
+	if (!ne2k_has_data) {
+		//if (ne2k_rx_stat() != NE2K_STAT_RX) {
+
+		if (filp->f_flags & O_NONBLOCK) {
+			res = -EAGAIN;
+			goto out;
 		}
-		res = size;
-		break;
+		do_wait();
+		if (current->signal) {
+			res = -EINTR;
+			goto out;
+		}
+	}
+	if (!rx_batch) {
+		res = ne2k_get_packet(data, len);
+		if ((int)res > 0)
+			netif_stat.rx_reads++;
+		goto out;
 	}
+	if (len < MAX_PACKET_ETH + sizeof(word_t)) {
+		res = -EINVAL;		/* no room for a full size packet */
+		goto out;
+	}
+	do {
+		if (len - res < MAX_PACKET_ETH + sizeof(word_t))
+			break;
+		size = ne2k_get_packet(data + res + sizeof(word_t), MAX_PACKET_ETH);
+		if (size < 0) {
+			if (!res)	/* else return packets already read */
+				res = size;
+			break;
+		}
+		put_user(size, (word_t *)(data + res));
+		res += size + sizeof(word_t);
+	} while (ne2k_has_data);
+	if ((int)res > 0)
+		netif_stat.rx_reads++;
 
+out:
 	finish_wait(&rxwait);
 	return res;
 }
@@ -152,6 +188,7 @@ static size_t ne2k_write(struct inode *inode, struct file *file, char *data, siz
 
 		if (len < 64) len = 64;  /* issue #133 */
 		ne2k_pack_put(data, len);
+		ktrace(KT_NETTX, len, 0);
 
 		res = len;
 		break;
@@ -313,6 +350,10 @@ static int ne2k_ioctl(struct inode *inode, struct file *file, unsigned int cmd,
 			err = verified_memcpy_tofs((char *)arg, &netif_stat, sizeof(netif_stat));
 			break;
 
+		case IOCTL_ETH_RXBATCH_SET:
+			rx_batch = arg;
+			break;
+
 		default:
 			err = -EINVAL;
 
@@ -351,6 +392,7 @@ static void ne2k_release(struct inode *inode, struct file *file)
 	if (--usecount == 0) {
 		ne2k_stop();
 		free_irq(net_irq);
+		rx_batch = 0;
 	}
 }
 
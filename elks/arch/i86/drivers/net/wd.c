@@ -23,6 +23,7 @@
 #include <linuxmt/mm.h>
 #include <linuxmt/debug.h>
 #include <linuxmt/netstat.h>
+#include <linuxmt/ktrace.h>
 #include "eth-msgs.h"
 
 /* runtime configuration set in /bootopts or defaults in ports.h */
@@ -436,6 +437,8 @@ static size_t wd_read(struct inode * inode, struct file * filp,
 			}
 		}
 		res = wd_pack_get(data, len);	/* returns packet data size read */
+		if ((int)res > 0)
+			ktrace(KT_NETRX, res, 0);
 	} while (0);
 
 	finish_wait(&rxwait);
@@ -493,6 +496,8 @@ static size_t wd_write(struct inode * inode, struct file * file,
 			}
 		}
 		res = wd_pack_put(data, len);
+		if (res >= 0)
+			ktrace(KT_NETTX, res, 0);
 	} while (0);
 	finish_wait(&txwait);
 	return res;
@@ -18,6 +18,7 @@
 #include <linuxmt/errno.h>
 #include <linuxmt/init.h>
 #include <linuxmt/kernel.h>
+#include <linuxmt/ktrace.h>
 #include <linuxmt/sched.h>
 #include <linuxmt/timer.h>
 #include <linuxmt/types.h>
@@ -48,7 +49,11 @@ void do_IRQ(int i, struct pt_regs *regs)
     irq_handler ih = irq_action [i];
     if (!ih)
         printk("Unexpected interrupt: %u\n", i);
-    else (*ih)(i, regs);
+    else {
+        ktrace(KT_IRQ, i, 0);
+        (*ih)(i, regs);
+        ktrace(KT_IRQDONE, i, 0);
+    }
 }
 
 /* install interrupt vector to point to handler trampoline */
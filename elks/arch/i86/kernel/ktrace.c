@@ -0,0 +1,82 @@
+#include <linuxmt/config.h>
+#include <linuxmt/kernel.h>
+#include <linuxmt/mm.h>
+#include <linuxmt/memory.h>
+#include <linuxmt/sched.h>
+#include <linuxmt/ktrace.h>
+
+#include <arch/io.h>
+#include <arch/irq.h>
+#include <arch/ports.h>
+#include <arch/segment.h>
+
+/*
+ * Kernel event trace ring
+ *
+ * Each event is stored with jiffies and the latched PIT countdown rather
+ * than a get_ptime delta, so events can be recorded from interrupt
+ * handlers without sharing timer state. The decoder in ktrace corrects
+ * for a timer wrap not yet counted in jiffies.
+ */
+
+#ifdef CONFIG_KTRACE
+
+#define ENTRY_SIZE      sizeof(struct ktrace_event)
+#define PIT_RELOAD      11932U          /* MAX_PTICK in prectimer.c */
+
+int ktrace_mask;
+struct ktrace_info ktrace_info = { 0, 0, KTRACE_ENTRIES, PIT_RELOAD };
+static segment_s *ktrace_seg;
+
+/* called from any context, records one event with interrupts disabled */
+void ktrace_event(int type, unsigned int arg1, unsigned long arg2)
+{
+    unsigned int off, lo, hi;
+    seg_t seg;
+    flag_t flags;
+
+    save_flags(flags);
+    clr_irq();
+    if ((seg = ktrace_info.seg) != 0) {
+        outb(0, TIMER_CMDS_PORT);       /* latch timer value */
+        lo = inb(TIMER_DATA_PORT);
+        hi = inb(TIMER_DATA_PORT) << 8;
+        off = ((unsigned)ktrace_info.count & (KTRACE_ENTRIES - 1)) * ENTRY_SIZE;
+        ktrace_info.count++;
+        pokel(off + 0, seg, jiffies);
+        pokew(off + 4, seg, PIT_RELOAD - (lo | hi));
+        pokew(off + 6, seg, type);
+        pokew(off + 8, seg, current->pid);
+        pokew(off + 10, seg, arg1);
+        pokel(off + 12, seg, arg2);
+    }
+    restore_flags(flags);
+}
+
+/* called by sysctl after kern.ktrace is set, restarts or frees ring */
+void ktrace_start(void)
+{
+    if (!ktrace_mask) {
+        if (ktrace_seg) {
+            ktrace_info.seg = 0;        /* ktrace_event checks with irqs off */
+            ktrace_info.count = 0;
+            seg_free(ktrace_seg);
+            ktrace_seg = NULL;
+        }
+        return;
+    }
+    if (ktrace_mask == KTC_KEEP)        /* stopped, leave ring for display */
+        return;
+    if (!ktrace_seg) {
+        ktrace_seg = seg_alloc((KTRACE_ENTRIES * ENTRY_SIZE) >> 4, SEG_FLAG_EXTBUF);
+        if (!ktrace_seg) {
+            printk("ktrace: no memory for trace ring\n");
+            ktrace_mask = 0;
+            return;
+        }
+        ktrace_info.seg = ktrace_seg->base;
+    }
+    ktrace_info.count = 0;
+}
+
+#endif /* CONFIG_KTRACE */
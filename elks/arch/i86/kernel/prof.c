@@ -0,0 +1,144 @@
+#include <linuxmt/config.h>
+#include <linuxmt/errno.h>
+#include <linuxmt/init.h>
+#include <linuxmt/kernel.h>
+#include <linuxmt/mm.h>
+#include <linuxmt/memory.h>
+#include <linuxmt/sched.h>
+#include <linuxmt/prof.h>
+
+#include <arch/irq.h>
+#include <arch/param.h>
+#include <arch/segment.h>
+
+/*
+ * Sampling profiler
+ *
+ * On each timer tick the interrupted CS:IP and current pid are counted
+ * in a hashed histogram kept in a far memory segment, so both kernel and
+ * user hot spots show up without using kernel data segment space.
+ * The histogram is controlled and read by the kprof system call and
+ * symbolized by the kprof utility.
+ */
+
+#ifdef CONFIG_PROFILE
+
+#define ENTRY_SIZE      sizeof(struct kprof_sample)
+
+static segment_s *prof_seg;
+static struct kprof_info info;
+static unsigned int read_pos;
+
+/* called from timer interrupt with interrupts enabled */
+void prof_sample(struct pt_regs *regs)
+{
+    unsigned int ip, cs, pid, idx, off, count;
+    int n;
+
+    if (!info.running)
+        return;
+    /* interrupted stack holds BP, IP, CS, flags (struct uregs) */
+    ip = peekw(regs->sp + 2, regs->ss);
+    cs = peekw(regs->sp + 4, regs->ss);
+    pid = current->pid;
+    info.samples++;
+
+    idx = ((ip >> 1) ^ cs ^ (pid << 7)) & (KPROF_ENTRIES - 1);
+    for (n = KPROF_PROBES; n > 0; n--) {
+        off = idx * ENTRY_SIZE;
+        count = peekw(off + 6, prof_seg->base);
+        if (count == 0) {
+            pokew(off + 0, prof_seg->base, ip);
+            pokew(off + 2, prof_seg->base, cs);
+            pokew(off + 4, prof_seg->base, pid);
+            pokew(off + 6, prof_seg->base, 1);
+            info.entries++;
+            return;
+        }
+        if (peekw(off + 0, prof_seg->base) == ip && peekw(off + 2, prof_seg->base) == cs
+            && peekw(off + 4, prof_seg->base) == pid) {
+            if (count != 0xFFFF)
+                pokew(off + 6, prof_seg->base, count + 1);
+            return;
+        }
+        idx = (idx + 1) & (KPROF_ENTRIES - 1);
+    }
+    info.lost++;
+}
+
+/* copy used entries to user buffer, returns bytes copied, 0 at end */
+static int prof_read(char *buf, size_t len)
+{
+    unsigned int off;
+    size_t n = 0;
+    int error;
+
+    if ((error = verify_area(VERIFY_WRITE, buf, len)) != 0)
+        return error;
+    while (read_pos < KPROF_ENTRIES && n + ENTRY_SIZE <= len) {
+        off = read_pos++ * ENTRY_SIZE;
+        if (peekw(off + 6, prof_seg->base) == 0)
+            continue;
+        fmemcpyw(buf + n, current->t_regs.ds, (void *)off, prof_seg->base,
+            ENTRY_SIZE / 2);
+        n += ENTRY_SIZE;
+    }
+    return n;
+}
+
+int sys_kprof(int op, char *buf, size_t len)
+{
+    if (!suser())
+        return -EPERM;
+
+    switch (op) {
+    case KPROF_START:
+        info.running = 0;
+        if (!prof_seg) {
+            prof_seg = seg_alloc((KPROF_ENTRIES * ENTRY_SIZE) >> 4, SEG_FLAG_EXTBUF);
+            if (!prof_seg)
+                return -ENOMEM;
+        }
+        fmemsetw(0, prof_seg->base, 0, KPROF_ENTRIES * ENTRY_SIZE / 2);
+        info.samples = info.lost = 0;
+        info.entries = 0;
+        info.running = 1;
+        break;
+
+    case KPROF_STOP:
+        info.running = 0;
+        break;
+
+    case KPROF_INFO:
+        read_pos = 0;
+        info.kernel_cs = kernel_cs;
+#if defined(CONFIG_FARTEXT_KERNEL) && !defined(__STRICT_ANSI__)
+        info.fartext_cs = _FP_SEG(__start_fartext_init);
+#else
+        info.fartext_cs = 0;
+#endif
+        info.hz = HZ;
+        if (len < sizeof(info))
+            return -EINVAL;
+        return verified_memcpy_tofs(buf, &info, sizeof(info));
+
+    case KPROF_READ:
+        if (!prof_seg)
+            return 0;
+        return prof_read(buf, len);
+
+    case KPROF_FREE:
+        info.running = 0;
+        if (prof_seg) {
+            seg_free(prof_seg);
+            prof_seg = NULL;
+        }
+        break;
+
+    default:
+        return -EINVAL;
+    }
+    return 0;
+}
+
+#endif /* CONFIG_PROFILE */
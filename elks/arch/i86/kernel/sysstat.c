@@ -0,0 +1,125 @@
+#include <linuxmt/config.h>
+#include <linuxmt/errno.h>
+#include <linuxmt/kernel.h>
+#include <linuxmt/mm.h>
+#include <linuxmt/memory.h>
+#include <linuxmt/sched.h>
+#include <linuxmt/prectimer.h>
+#include <linuxmt/sysstat.h>
+
+#include <arch/segment.h>
+
+/*
+ * Per system call statistics
+ *
+ * Called from _irqit around each system call, counting calls and
+ * accumulating total and maximum elapsed time per call number using the
+ * precision timer. The table is kept in a far memory segment allocated
+ * only while statistics are wanted, and is read by the sysstat utility.
+ * When stopped, the cost per system call is two calls and a test.
+ */
+
+#ifdef CONFIG_SYSSTAT
+
+#define ENTRY_SIZE      sizeof(struct sysstat)
+#define PTICKS_PER_JIFFY 11932U         /* MAX_PTICK in prectimer.c */
+
+static segment_s *stat_seg;
+static int running;
+static unsigned long ptime;             /* running precision time, never 0 */
+static unsigned int lastjiffies;
+
+/* return running time in pticks, kept monotonic from get_ptime deltas */
+static unsigned long sysstat_time(void)
+{
+    unsigned long pticks = get_ptime();
+
+    /* get_ptime returns 0 when over ~42s since last call, fall back to jiffies */
+    if (pticks == 0)
+        pticks = ((unsigned)jiffies - lastjiffies) * (unsigned long)PTICKS_PER_JIFFY;
+    lastjiffies = (unsigned)jiffies;
+    ptime += pticks;
+    if (ptime == 0)
+        ptime = 1;
+    return ptime;
+}
+
+void sysstat_begin(void)
+{
+    unsigned int off;
+
+    if (!running || current->t_regs.orig_ax >= SYSSTAT_CALLS)
+        return;
+    off = current->t_regs.orig_ax * ENTRY_SIZE;
+    pokel(off, stat_seg->base, peekl(off, stat_seg->base) + 1);
+    current->t_sysstart = sysstat_time();
+}
+
+void sysstat_end(void)
+{
+    unsigned int off;
+    unsigned long pticks;
+
+    if (!running || !current->t_sysstart)
+        return;
+    pticks = sysstat_time() - current->t_sysstart;
+    current->t_sysstart = 0;
+    off = current->t_regs.orig_ax * ENTRY_SIZE;
+    pokel(off + 4, stat_seg->base, peekl(off + 4, stat_seg->base) + pticks);
+    if (pticks > peekl(off + 8, stat_seg->base))
+        pokel(off + 8, stat_seg->base, pticks);
+}
+
+int sys_sysstat(int op, char *buf, size_t len)
+{
+    struct task_struct *p;
+
+    if (op != SYSSTAT_READ && !suser())
+        return -EPERM;
+
+    switch (op) {
+    case SYSSTAT_START:
+        running = 0;
+        if (!stat_seg) {
+            stat_seg = seg_alloc((SYSSTAT_CALLS * ENTRY_SIZE + 15) >> 4, SEG_FLAG_EXTBUF);
+            if (!stat_seg)
+                return -ENOMEM;
+        }
+        fmemsetw(0, stat_seg->base, 0, SYSSTAT_CALLS * ENTRY_SIZE / 2);
+        /* forget calls in progress, including this one */
+        for_each_task(p)
+            p->t_sysstart = 0;
+        sysstat_time();
+        running = 1;
+        break;
+
+    case SYSSTAT_STOP:
+        running = 0;
+        break;
+
+    case SYSSTAT_READ:
+        if (!stat_seg)
+            return 0;
+        if (len > SYSSTAT_CALLS * ENTRY_SIZE)
+            len = SYSSTAT_CALLS * ENTRY_SIZE;
+        len &= ~1;
+        if (verify_area(VERIFY_WRITE, buf, len))
+            return -EFAULT;
+        fmemcpyw(buf, current->t_regs.ds, 0, stat_seg->base, len / 2);
+        return len;
+
+    case SYSSTAT_FREE:
+        running = 0;
+        if (stat_seg) {
+            seg_free(stat_seg);
+            stat_seg = NULL;
+        }
+        break;
+
+    default:
+        return -EINVAL;
+    }
+    return 0;
+}
+
+#endif /* CONFIG_SYSSTAT */
@@ -4,6 +4,7 @@
 #include <linuxmt/timer.h>
 #include <linuxmt/ntty.h>
 #include <linuxmt/fixedpt.h>
+#include <linuxmt/prof.h>
 
 #include <arch/io.h>
 #include <arch/irq.h>
@@ -65,6 +66,10 @@ void timer_tick(int irq, struct pt_regs *regs)
     calc_cpu_usage();
 #endif
 
+#ifdef CONFIG_PROFILE
+    prof_sample(regs);
+#endif
+
 #if defined(CONFIG_CHAR_DEV_RS) && (defined(CONFIG_FAST_IRQ4) || defined(CONFIG_FAST_IRQ3))
     rs_pump();          /* check if received serial chars and call wake_up*/
 #endif
@@ -294,6 +294,23 @@ int sys_fmemalloc(int paras, unsigned short *pseg)
 	return 0;
 }
 
+// release a segment allocated by sys_fmemalloc
+int sys_fmemfree(unsigned short base)
+{
+	list_s *n;
+
+	for (n = _seg_all.next; n != &_seg_all; n = n->next) {
+		segment_s * seg = structof (n, segment_s, all);
+
+		if (seg->base == base && seg->pid == current->pid
+		    && (seg->flags & SEG_FLAG_TYPE) == SEG_FLAG_FDAT) {
+			seg_free(seg);
+			return 0;
+		}
+	}
+	return -EINVAL;
+}
+
 // free all program allocated segments for PID pid
 void seg_free_pid(pid_t pid)
 {
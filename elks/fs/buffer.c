@@ -9,6 +9,7 @@
 #include <linuxmt/heap.h>
 #include <linuxmt/errno.h>
 #include <linuxmt/trace.h>
+#include <linuxmt/ktrace.h>
 #include <linuxmt/debug.h>
 
 #include <arch/system.h>
@@ -502,6 +503,7 @@ struct buffer_head *getblk32(kdev_t dev, block32_t block)
     ebh->b_dev = dev;
     ebh->b_blocknr = block;
     debug_cache2("BM %lu ", block);
+    ktrace(KT_BMISS, dev, block);
     goto return_it;
 
   found_it:
@@ -513,6 +515,7 @@ struct buffer_head *getblk32(kdev_t dev, block32_t block)
     }
     if (bh->b_data) { debug_cache2("L1 %lu ", block); }
                else { debug_cache2("L2 %lu ", block); }
+    ktrace(KT_BHIT, dev, block);
     ebh = EBH(bh);
     INR_COUNT(ebh);
     wait_on_buffer(bh);
@@ -17,6 +17,8 @@ extern void chq_addch(register struct ch_queue *,unsigned char);
 extern void chq_addch_nowakeup(register struct ch_queue *,unsigned char);
 extern int chq_peekch(register struct ch_queue *);
 extern int chq_getch(register struct ch_queue *);
+extern int chq_write(register struct ch_queue *,char *,int);
+extern int chq_read(register struct ch_queue *,char *,int);
 /*extern int chq_full(register struct ch_queue *);*/
 
 #endif
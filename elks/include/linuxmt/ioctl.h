@@ -6,6 +6,9 @@
 /* Block device generic driver operations */
 #define IOCTL_BLK_GET_SECTOR_SIZE 0x0330    /* ioctl get drive sector size */
 
+/* Parallel port driver operations */
+#define IOCTL_LP_GETSTAT        0x0601  /* get struct lp_stat */
+
 /* Ethernet generic driver operations */
 #define IOCTL_ETH_ADDR_GET      0x0901
 #define IOCTL_ETH_ADDR_SET      0x0902
@@ -13,5 +16,6 @@
 #define IOCTL_ETH_GETSTAT       0x0904  /* get error stats from NIC */
 #define IOCTL_ETH_OFWSKIP_SET   0x0906  /* Set # of packets to skip on buffer overflow */
 #define IOCTL_ETH_OFWSKIP_GET   0x0905  /* get current overrflow skip value */
+#define IOCTL_ETH_RXBATCH_SET   0x0907  /* read multiple length-prefixed packets */
 
 #endif
@@ -0,0 +1,75 @@
+#ifndef __LINUXMT_KTRACE_H
+#define __LINUXMT_KTRACE_H
+
+#include <linuxmt/config.h>
+#include <linuxmt/types.h>
+
+/*
+ * Kernel event trace ring, CONFIG_KTRACE
+ *
+ * Events are timestamped and stored in binary in a far memory ring,
+ * without console output. Event classes are enabled by setting the
+ * kern.ktrace sysctl to a mask of KTC_* bits, which also restarts the
+ * ring. Setting KTC_KEEP alone stops tracing but keeps the ring, setting
+ * 0 frees it. The ring is read from /dev/kmem and decoded by ktrace.
+ */
+
+/* event classes for kern.ktrace mask */
+#define KTC_SCHED       0x01    /* context switches */
+#define KTC_IRQ         0x02    /* hardware interrupts */
+#define KTC_BLOCK       0x04    /* block I/O requests */
+#define KTC_BUFFER      0x08    /* buffer cache lookups */
+#define KTC_NET         0x10    /* network packets */
+#define KTC_KEEP        0x8000  /* no events, keep ring after stop */
+
+/* event types, high nibble is class bit number */
+#define KT_SWITCH       0x00    /* arg1 previous pid, arg2 next pid */
+#define KT_IRQ          0x10    /* arg1 irq, handler entry */
+#define KT_IRQDONE      0x11    /* arg1 irq, handler exit */
+#define KT_BREAD        0x20    /* arg1 dev, arg2 block, request queued */
+#define KT_BWRITE       0x21    /* arg1 dev, arg2 block, request queued */
+#define KT_BDONE        0x22    /* arg1 dev, arg2 block, request complete */
+#define KT_BERROR       0x23    /* arg1 dev, arg2 block, request failed */
+#define KT_BHIT         0x30    /* arg1 dev, arg2 block, found in cache */
+#define KT_BMISS        0x31    /* arg1 dev, arg2 block, not in cache */
+#define KT_NETRX        0x40    /* arg1 length, packet read by ktcp */
+#define KT_NETTX        0x41    /* arg1 length, packet written by ktcp */
+
+#define KTRACE_ENTRIES  1024    /* ring entries, must be power of two */
+
+struct ktrace_event {
+    unsigned long jiffies;
+    unsigned short pit;         /* PIT pticks (0.838us) since jiffies tick */
+    unsigned short type;
+    unsigned short pid;         /* current (interrupted) process */
+    unsigned short arg1;
+    unsigned long arg2;
+};
+
+/* ring description, address returned by MEM_GETKTRACE */
+struct ktrace_info {
+    unsigned long count;        /* events written since start */
+    seg_t seg;                  /* ring segment, 0 if never started */
+    unsigned short entries;
+    unsigned short reload;      /* PIT reload value per jiffy */
+};
+
+#ifdef __KERNEL__
+#ifdef CONFIG_KTRACE
+extern int ktrace_mask;
+extern struct ktrace_info ktrace_info;
+
+void ktrace_event(int type, unsigned int arg1, unsigned long arg2);
+void ktrace_start(void);
+
+#define ktrace(type, arg1, arg2) \
+    do { \
+        if (ktrace_mask & (1 << ((type) >> 4))) \
+            ktrace_event(type, arg1, arg2); \
+    } while (0)
+#else
+#define ktrace(type, arg1, arg2)
+#endif
+#endif
+
+#endif
@@ -12,6 +12,8 @@
 
 #define LP_EXIST	0x01
 #define LP_BUSY		0x04
+#define LP_IRQ		0x08 /* interrupt driven */
+#define LP_TIMER	0x10 /* kick timer pending */
 
 /* define offsets from base port address for status and control port */
 
@@ -33,6 +35,7 @@
 #define LP_CONTROL(val, p)	\
 	outb_p((unsigned char) (val), (void *) ((p)->io + CONTROL));
 
+#define LP_IRQEN	0x10 /* active high: interrupt on ack */
 #define LP_SELECT	0x08 /* active low: printer is selected */
 #define LP_INIT		0x04 /* active low: reset */
 #define LP_AUTOLF	0x02 /* active low: auto insert lf for cf */
@@ -45,10 +48,15 @@
 
 /* microseconds to assert reset */
 #define LP_RESET_WAIT	50
-/* loops to busy-wait for printer to be ready to receive char */
-#define LP_CHAR_WAIT	1000
-/* jiffies to wait for space in printer buffer */
+/* max chars sent per interrupt or timer tick while printer not busy */
+#define LP_BURST	16
+/* jiffies between kicks when interrupts lost or not used */
 #define LP_TIME_WAIT	(HZ / 10)
+#define LP_POLL_WAIT	1
+
+/* far memory output buffer size, must be power of two */
+#define LP_BUFSIZE	4096
+#define LP_BUFMASK	(LP_BUFSIZE - 1)
 
 /* defines max number of ports */
 #ifndef BIOS_PORTS
@@ -64,4 +72,13 @@
 
 #define LP_DEVICE_NAME	"lp"
 
+/* IOCTL_LP_GETSTAT statistics */
+struct lp_stat {
+    unsigned long chars;	/* chars sent to printer */
+    unsigned long irqs;		/* ack interrupts */
+    unsigned long ticks;	/* jiffies spent with output pending */
+    unsigned int errors;	/* paper out, offline or error reported */
+    unsigned int irq;		/* 0 when polling */
+};
+
 #endif
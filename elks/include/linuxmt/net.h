@@ -20,7 +20,7 @@ typedef enum {
 #ifdef __KERNEL__
 struct socket {
     unsigned char state;
-    unsigned char flags;
+    unsigned int flags;
     struct wait_queue *wait;
     unsigned int rcv_bufsiz;
     struct proto_ops *ops;
@@ -38,6 +38,7 @@ struct socket {
     sem_t sem;			/* one operation at a time per socket */
     int avail_data;		/* data available for reading from ktcp */
     int retval;			/* event return value from ktcp */
+    int rdretval;		/* read return value from ktcp */
     __u32 remaddr;		/* all in network byte order */
     __u32 localaddr;
     __u16 remport;
@@ -80,6 +81,10 @@ struct proto_ops {
 #define SF_RST_ON_CLOSE	(1 << 4) /* inet */
 #define SF_REUSE_ADDR	(1 << 5) /* inet */
 #define SF_CONNECT	(1 << 6) /* inet */
+#define SF_REPLY	(1 << 7) /* inet */
+#define SF_READING	(1 << 8) /* inet */
+#define SF_RDREPLY	(1 << 9) /* inet */
+#define SF_WRITABLE	(1 << 10) /* inet */
 
 struct net_proto {
     const char *name;		/* Protocol name */
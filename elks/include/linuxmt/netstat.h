@@ -35,6 +35,8 @@ struct netif_stat {
 	unsigned int if_status;	    /* Interface status flags */
 	int oflow_keep;	            /* # of packets to keep if overflow */
 	char mac_addr[6];	        /* Current MAC address */
+	unsigned int rx_packets;    /* Packets received */
+	unsigned int rx_reads;      /* Reads returning packets, < rx_packets if batched */
 };
 
 #endif	/* __ASSEMBLER__ */
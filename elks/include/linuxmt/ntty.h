@@ -12,7 +12,7 @@
 #define PTYINQ_SIZE	80	/* pty input queue size*/
 #define PTYOUTQ_SIZE	512	/* pty output queue size (=TDB_WRITE_MAX and telnetd buffer)*/
 
-#define RSINQ_SIZE	1024	/* serial input queue SLIP_MTU+128+8*/
+#define RSINQ_SIZE	1160	/* serial input queue SLIP_MTU+128+8*/
 #define RSOUTQ_SIZE	80	/* serial output queue size*/
 
 /*
@@ -99,6 +99,12 @@ extern int pipe_lseek(struct inode *,struct file *,off_t,int);
 extern int tty_outproc(register struct tty *);
 		/* TTY postprocessing */
 
+/* SLIP line discipline codes */
+#define SLIP_END	0300
+#define SLIP_ESC	0333
+#define SLIP_ESC_END	0334
+#define SLIP_ESC_ESC	0335
+
 extern struct termios def_vals;
 		/* global use of def_vals */
 
@@ -0,0 +1,38 @@
+#ifndef __LINUXMT_PROF_H
+#define __LINUXMT_PROF_H
+
+/* kprof(2) sampled kernel and user profiler, CONFIG_PROFILE */
+
+#define KPROF_START     1       /* allocate/clear histogram and start sampling */
+#define KPROF_STOP      2       /* stop sampling */
+#define KPROF_INFO      3       /* get struct kprof_info, rewind KPROF_READ */
+#define KPROF_READ      4       /* read next used histogram entries */
+#define KPROF_FREE      5       /* stop sampling and release histogram */
+
+#define KPROF_ENTRIES   4096    /* histogram entries, must be power of two */
+#define KPROF_PROBES    8       /* hash probes before sample is counted lost */
+
+/* histogram entry, one per distinct interrupted CS:IP and pid */
+struct kprof_sample {
+    unsigned short ip;
+    unsigned short cs;
+    unsigned short pid;
+    unsigned short count;       /* 0 = unused */
+};
+
+struct kprof_info {
+    unsigned long samples;      /* timer ticks sampled */
+    unsigned long lost;         /* samples not recorded, histogram full */
+    unsigned short entries;     /* histogram entries in use */
+    unsigned short running;     /* sampling active */
+    unsigned short kernel_cs;   /* kernel .text segment */
+    unsigned short fartext_cs;  /* kernel .fartext segment, 0 if none */
+    unsigned short hz;          /* sampling rate */
+};
+
+#ifdef __KERNEL__
+struct pt_regs;
+void prof_sample(struct pt_regs *regs);
+#endif
+
+#endif
@@ -86,6 +86,10 @@ struct task_struct {
     int                         kstack_max;
     int                         kstack_prevmax;
 
+    /* start time of the current system call, 0 when not measuring, used only
+     * by CONFIG_SYSSTAT but likewise always present so 'ps' sees one layout */
+    unsigned long               t_sysstart;
+
     unsigned int                kstack_magic;   /* To detect stack corruption */
     __u16                       t_kstack[KSTACK_BYTES/2];
     struct pt_regs              t_regs;         /* registers on stack during syscall */
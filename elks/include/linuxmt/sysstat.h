@@ -0,0 +1,25 @@
+#ifndef __LINUXMT_SYSSTAT_H
+#define __LINUXMT_SYSSTAT_H
+
+/* sysstat(2) per system call count and latency statistics, CONFIG_SYSSTAT */
+
+#define SYSSTAT_START   1       /* allocate/clear statistics and start counting */
+#define SYSSTAT_STOP    2       /* stop counting */
+#define SYSSTAT_READ    3       /* read struct sysstat array indexed by call number */
+#define SYSSTAT_FREE    4       /* stop counting and release statistics */
+
+#define SYSSTAT_CALLS   224     /* call numbers counted, must cover syscall.dat */
+
+/* times are in 0.838us precision timer pticks, see prectimer.c */
+struct sysstat {
+    unsigned long count;        /* calls made */
+    unsigned long total;        /* total time in call, including sleeps */
+    unsigned long max;          /* longest single call */
+};
+
+#ifdef __KERNEL__
+void sysstat_begin(void);
+void sysstat_end(void);
+#endif
+
+#endif
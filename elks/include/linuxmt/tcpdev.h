@@ -18,6 +18,12 @@
 
 #define TCPDEV_MAXREAD TCPDEV_INBUFFERSIZE - sizeof(struct tdb_return_data)
 
+/*
+ * Reads and writes of tcpdev carry a batch of messages,
+ * each preceded by its length in bytes.
+ */
+typedef unsigned short tdb_len_t;
+
 /* outgoing ops */
 #define TDC_BIND	1
 #define TDC_ACCEPT	2
@@ -26,6 +32,7 @@
 #define TDC_RELEASE	5
 #define TDC_READ	8
 #define TDC_WRITE	9
+#define TDC_CANCEL	10
 
 struct tdb_release {
     unsigned char cmd;
@@ -75,6 +82,15 @@ struct tdb_write {
     unsigned char data[TDB_WRITE_MAX];
 };
 
+/* cancel blocked read*/
+struct tdb_cancel {
+    unsigned char cmd;
+    struct socket *sock;
+};
+
+/* tdb_write message length without unused data*/
+#define TDB_WRITE_LEN(size)	(sizeof(struct tdb_write) - TDB_WRITE_MAX + (size))
+
 /* incoming (ktcp to kernel) ops */
 #define	TDT_RETURN	1
 #define	TDT_CHG_STATE	2
@@ -82,6 +98,8 @@ struct tdb_write {
 #define TDT_ACCEPT	4
 #define TDT_BIND	5
 #define TDT_CONNECT	6
+#define TDT_READ	7	/* reply to TDC_READ, may carry data */
+#define TDT_WRITABLE	8	/* send space freed after write was refused */
 
 struct tdb_return_data {
     char type;
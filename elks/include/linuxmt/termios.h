@@ -45,6 +45,23 @@
 #define TIOCGETD	(__TERMIOS_MAJ+0x24)
 #define TCSBRKP		(__TERMIOS_MAJ+0x25)	/* Needed for POSIX tcsendbreak() */
 #define TIOCTTYGSTRUCT	(__TERMIOS_MAJ+0x26)	/* For debugging only */
+
+/* line disciplines for TIOCSETD/TIOCGETD */
+#define N_TTY		0
+#define N_SLIP		1	/* serial driver frames SLIP, one packet per read/write */
+
+/* TIOCGSERIAL/TIOCSSERIAL argument, only rx_trigger can be set */
+struct serial_struct {
+	unsigned char	type;		/* UART type */
+	unsigned char	rx_trigger;	/* receive FIFO trigger level 1, 4, 8 or 14 */
+	unsigned char	tx_fifo;	/* bytes sent per transmit interrupt */
+	unsigned long	rx_chars;	/* characters received */
+	unsigned long	tx_chars;	/* characters transmitted */
+	unsigned int	overruns;	/* UART receive overruns */
+	unsigned int	rx_dropped;	/* characters lost, input queue full */
+	unsigned int	errors;		/* framing and parity errors */
+};
+
 #define FIONCLEX	(__TERMIOS_MAJ+0x50)	/* these numbers need to be adjusted. */
 #define FIOCLEX		(__TERMIOS_MAJ+0x51)
 #define FIOASYNC	(__TERMIOS_MAJ+0x52)
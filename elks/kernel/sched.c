@@ -11,6 +11,7 @@
 #include <linuxmt/timer.h>
 #include <linuxmt/string.h>
 #include <linuxmt/trace.h>
+#include <linuxmt/ktrace.h>
 #include <linuxmt/debug.h>
 
 #include <arch/irq.h>
@@ -110,6 +111,7 @@ void schedule(void)
             add_timer(&timer);
         }
 
+        ktrace(KT_SWITCH, prev->pid, next->pid);
         previous = prev;
         current = next;
         debug_sched("sched: %P\n");
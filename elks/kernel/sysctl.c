@@ -4,11 +4,13 @@
 #include <linuxmt/sysctl.h>
 
 #include <linuxmt/trace.h>
+#include <linuxmt/ktrace.h>
 #include <linuxmt/kernel.h>
 
 struct sysctl {
     const char *name;
     int *value;
+    void (*changed)(void);      /* called after value is set, may be NULL */
 };
 
 static int malloc_debug;
@@ -18,6 +20,9 @@ struct sysctl sysctl[] = {
     { "kern.debug",         &debug_level        },  /* debug level (^P toggled) */
     { "kern.strace",        &tracing            },  /* strace=1, kstack=2 */
     { "kern.console",       (int *)&dev_console },  /* console */
+#ifdef CONFIG_KTRACE
+    { "kern.ktrace",        &ktrace_mask, ktrace_start }, /* KTC_* event classes */
+#endif
     { "malloc.debug",       &malloc_debug       },
     { "net.debug",          &net_debug          },
 };
@@ -55,9 +60,11 @@ int sys_sysctl(int op, char *name, int *value)
 
     if (op == CTL_GET)
             put_user(*sc->value, value);
-    else if (op == CTL_SET)
+    else if (op == CTL_SET) {
             *sc->value = get_user(value);
-    else
+            if (sc->changed)
+                sc->changed();
+    } else
         return -EINVAL;
     return 0;
 }
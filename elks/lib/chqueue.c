@@ -26,6 +26,7 @@
 #include <linuxmt/types.h>
 #include <linuxmt/errno.h>
 #include <linuxmt/debug.h>
+#include <linuxmt/mm.h>
 #include <arch/irq.h>
 
 void chq_init(register struct ch_queue *q, unsigned char *buf, int size)
@@ -79,6 +80,62 @@ void chq_addch_nowakeup(register struct ch_queue *q, unsigned char c)
     set_irq();
 }
 
+/*
+ * Copy up to len bytes from user space into queue, without wakeup.
+ * Copies in at most two runs, returns number of bytes added.
+ */
+int chq_write(register struct ch_queue *q, char *buf, int len)
+{
+    int n, count = 0;
+
+    /* only interrupt routines removing chars can change len, making more room*/
+    while (len > 0 && q->len < q->size) {
+	n = q->size - q->len;
+	if (n > q->size - q->head)
+	    n = q->size - q->head;		/* contiguous run to end of buffer*/
+	if (n > len)
+	    n = len;
+	memcpy_fromfs(q->base + q->head, buf, n);
+	buf += n;
+	len -= n;
+	count += n;
+	clr_irq();
+	if ((q->head += n) >= q->size)
+	    q->head = 0;
+	q->len += n;
+	set_irq();
+    }
+    return count;
+}
+
+/*
+ * Copy up to len bytes from queue into user space.
+ * Copies in at most two runs, returns number of bytes removed.
+ */
+int chq_read(register struct ch_queue *q, char *buf, int len)
+{
+    int n, count = 0;
+
+    /* only interrupt routines adding chars can change len, making more data*/
+    while (len > 0 && q->len) {
+	n = q->len;
+	if (n > q->size - q->tail)
+	    n = q->size - q->tail;		/* contiguous run to end of buffer*/
+	if (n > len)
+	    n = len;
+	memcpy_tofs(buf, q->base + q->tail, n);
+	buf += n;
+	len -= n;
+	count += n;
+	clr_irq();
+	if ((q->tail += n) >= q->size)
+	    q->tail = 0;
+	q->len -= n;
+	set_irq();
+    }
+    return count;
+}
+
 int chq_wait_rd(register struct ch_queue *q, int nonblock)
 {
     int	res = 0;
@@ -29,13 +29,19 @@
 #ifdef CONFIG_INET
 
 extern unsigned char tdin_buf[];
-extern sem_t bufin_sem, bufout_sem;
+extern sem_t bufin_sem;
 extern char tcpdev_inuse;
 extern int tcpdev_inetwrite(void *data, unsigned int len);
-extern char *get_tdout_buf(void);
-
-static sem_t rwlock;    /* global inet_read/write semaphore*/
+extern char *get_tdout_buf(unsigned int len);
 
+/*
+ * Replies from ktcp are delivered to each socket by setting SF_REPLY and
+ * sock->retval, so requests on different sockets can be outstanding at
+ * the same time. The socket semaphore allows one request per socket.
+ * Reads have their own reply (TDT_READ, SF_RDREPLY and sock->rdretval), so
+ * a read parked in ktcp waiting for data doesn't hold the semaphore.
+ * Only a read reply carrying data holds tdin_buf until copied to the user.
+ */
 int inet_process_tcpdev(register char *buf, int len)
 {
     register struct socket *sock;
@@ -56,32 +62,61 @@ int inet_process_tcpdev(register char *buf, int len)
         break;
 
     case TDT_AVAIL_DATA:
-        down(&sock->sem);
         sock->avail_data = ((struct tdb_return_data *)buf)->ret_value;
         debug_net("INET(%P) sock %x avail %u bufin %d\n",
             sock, sock->avail_data, bufin_sem);
-        up(&sock->sem);
         tcpdev_clear_data_avail();
         wake_up(sock->wait);
         break;
 
     case TDT_CONNECT:
-        down(&sock->sem);
         sock->flags |= SF_CONNECT;
         sock->retval = ((struct tdb_return_data *)buf)->ret_value;
         debug_net("INET(%P) sock %x connect %d bufin %d\n",
             sock, sock->retval, bufin_sem);
-        up(&sock->sem);
         tcpdev_clear_data_avail();
         wake_up(sock->wait);
         break;
 
-    case TDT_RETURN:
-    case TDT_ACCEPT:
     case TDT_BIND:
-        debug_net("INET(%P) retval %d bufin %d\n",
-            ((struct tdb_return_data *)buf)->ret_value, bufin_sem);
-        /* tcpdev_clear_data_avail() called by woken process */
+        sock->localaddr = ((struct tdb_bind_ret *)buf)->addr_ip;
+        sock->localport = ((struct tdb_bind_ret *)buf)->addr_port;
+        goto reply;
+
+    case TDT_ACCEPT:
+        /* peer address held in listen socket until inet_accept copies it */
+        sock->remaddr = ((struct tdb_accept_ret *)buf)->addr_ip;
+        sock->remport = ((struct tdb_accept_ret *)buf)->addr_port;
+        goto reply;
+
+    case TDT_RETURN:
+    reply:
+        sock->retval = ((struct tdb_return_data *)buf)->ret_value;
+        sock->flags |= SF_REPLY;
+        debug_net("INET(%P) retval %d bufin %d\n", sock->retval, bufin_sem);
+        tcpdev_clear_data_avail();
+        wake_up(sock->wait);
+        break;
+
+    case TDT_WRITABLE:
+        sock->flags |= SF_WRITABLE;
+        tcpdev_clear_data_avail();
+        wake_up(sock->wait);
+        break;
+
+    case TDT_READ:
+        /* a cancel after the read completed may bring a second reply, drop it */
+        if (!(sock->flags & SF_READING) || (sock->flags & SF_RDREPLY)) {
+            debug_net("INET(%P) read reply dropped, no read waiting\n");
+            tcpdev_clear_data_avail();
+            break;
+        }
+        sock->rdretval = ((struct tdb_return_data *)buf)->ret_value;
+        sock->flags |= SF_RDREPLY;
+        debug_net("INET(%P) read retval %d bufin %d\n", sock->rdretval, bufin_sem);
+        /* tdin_buf data released by woken process, tcpdev_clear_data_avail() */
+        if (((struct tdb_return_data *)buf)->size == 0)
+            tcpdev_clear_data_avail();
         wake_up(sock->wait);
         break;
     }
@@ -89,6 +124,18 @@ int inet_process_tcpdev(register char *buf, int len)
     return 1;
 }
 
+/* send command built in get_tdout_buf and sleep until ktcp replies */
+static int inet_request(register struct socket *sock, void *cmd, unsigned int len)
+{
+    sock->flags &= ~SF_REPLY;
+    tcpdev_inetwrite(cmd, len);
+
+    /* Sleep until tcpdev has news */
+    while (!(sock->flags & SF_REPLY))
+        interruptible_sleep_on(sock->wait);
+    return sock->retval;
+}
+
 static int inet_create(struct socket *sock, int protocol)
 {
     debug_net("INET(%P) create sock %x\n", sock);
@@ -114,7 +161,7 @@ static int inet_release(struct socket *sock, struct socket *peer)
     debug_net("INET(%P) release sock %x\n", sock);
     if (!tcpdev_inuse)
         return -EINVAL;
-    cmd = (struct tdb_release *)get_tdout_buf();
+    cmd = (struct tdb_release *)get_tdout_buf(sizeof(struct tdb_release));
     cmd->cmd = TDC_RELEASE;
     cmd->sock = sock;
     cmd->reset = sock->flags & SF_RST_ON_CLOSE;
@@ -135,25 +182,17 @@ static int inet_bind(register struct socket *sock, struct sockaddr *addr,
 
     /* TODO : Check if the user has permision to bind the port */
 
-    down(&rwlock);
-    cmd = (struct tdb_bind *)get_tdout_buf();
+    down(&sock->sem);
+    cmd = (struct tdb_bind *)get_tdout_buf(sizeof(struct tdb_bind));
     cmd->cmd = TDC_BIND;
     cmd->sock = sock;
     cmd->reuse_addr = sock->flags & SF_REUSE_ADDR;
     cmd->rcv_bufsiz = sock->rcv_bufsiz;
     memcpy_fromfs(&cmd->addr, addr, sockaddr_len);
 
-    tcpdev_inetwrite(cmd, sizeof(struct tdb_bind));
-
-    /* Sleep until tcpdev has news */
-    while (bufin_sem == 0)
-        interruptible_sleep_on(sock->wait);
-
-    sock->localaddr = ((struct tdb_bind_ret *)tdin_buf)->addr_ip;
-    sock->localport = ((struct tdb_bind_ret *)tdin_buf)->addr_port;
-    ret = ((struct tdb_return_data *)tdin_buf)->ret_value;
-    tcpdev_clear_data_avail();
-    up(&rwlock);
+    /* sock->localaddr and localport set from reply */
+    ret = inet_request(sock, cmd, sizeof(struct tdb_bind));
+    up(&sock->sem);
 
     debug_net("INET(%P) bind returns %d\n", ret);
     return (ret >= 0 ? 0 : ret);
@@ -176,7 +215,7 @@ static int inet_connect(struct socket *sock, struct sockaddr *uservaddr,
         return -EINPROGRESS;
 
     sock->flags &= ~SF_CONNECT;
-    cmd = (struct tdb_connect *)get_tdout_buf();
+    cmd = (struct tdb_connect *)get_tdout_buf(sizeof(struct tdb_connect));
     cmd->cmd = TDC_CONNECT;
     cmd->sock = sock;
     memcpy_fromfs(&cmd->addr, uservaddr, sockaddr_len);
@@ -201,21 +240,14 @@ static int inet_listen(register struct socket *sock, int backlog)
     int ret;
 
     debug("inet_listen(socket : 0x%x)\n", sock);
-    down(&rwlock);
-    cmd = (struct tdb_listen *)get_tdout_buf();
+    down(&sock->sem);
+    cmd = (struct tdb_listen *)get_tdout_buf(sizeof(struct tdb_listen));
     cmd->cmd = TDC_LISTEN;
     cmd->sock = sock;
     cmd->backlog = backlog;
 
-    tcpdev_inetwrite(cmd, sizeof(struct tdb_listen));
-
-    /* Sleep until tcpdev has news */
-    while (bufin_sem == 0)
-        interruptible_sleep_on(sock->wait);
-
-    ret = ((struct tdb_return_data *)tdin_buf)->ret_value;
-    tcpdev_clear_data_avail();
-    up(&rwlock);
+    ret = inet_request(sock, cmd, sizeof(struct tdb_listen));
+    up(&sock->sem);
 
     return ret;
 }
@@ -226,31 +258,32 @@ static int inet_accept(register struct socket *sock, struct socket *newsock, int
     int ret;
 
     debug_tune("INET(%P) accept wait sock %x newsock %x\n", sock, newsock);
-    cmd = (struct tdb_accept *)get_tdout_buf();
+    down(&sock->sem);
+    cmd = (struct tdb_accept *)get_tdout_buf(sizeof(struct tdb_accept));
     cmd->cmd = TDC_ACCEPT;
     cmd->sock = sock;
     cmd->newsock = newsock;
     cmd->nonblock = flags & O_NONBLOCK;
 
+    sock->flags &= ~SF_REPLY;
     tcpdev_inetwrite(cmd, sizeof(struct tdb_accept));
 
     /* Sleep until tcpdev has news */
-    do {        /* always sleep once to prevent accept race condition #1082 */
-
+    while (!(sock->flags & SF_REPLY)) {
         interruptible_sleep_on(sock->wait);
-        //interruptible_sleep_on(newsock->wait);
 
         if (current->signal) {
-            debug_net("INET(%P) accept RESTARTSYS bufin %d\n", bufin_sem);
+            debug_net("INET(%P) accept RESTARTSYS\n");
+            up(&sock->sem);
             return -ERESTARTSYS;
         }
-    } while (bufin_sem == 0);
+    }
 
     debug_tune("INET(%P) accepted sock %x newsock %x\n", sock, newsock);
-    newsock->remaddr = ((struct tdb_accept_ret *)tdin_buf)->addr_ip;
-    newsock->remport = ((struct tdb_accept_ret *)tdin_buf)->addr_port;
-    ret = ((struct tdb_accept_ret *)tdin_buf)->ret_value;
-    tcpdev_clear_data_avail();
+    newsock->remaddr = sock->remaddr;
+    newsock->remport = sock->remport;
+    ret = sock->retval;
+    up(&sock->sem);
     if (ret >= 0) {
         newsock->state = SS_CONNECTED;
         ret = 0;
@@ -261,7 +294,8 @@ static int inet_accept(register struct socket *sock, struct socket *newsock, int
 static int inet_read(struct socket *sock, char *ubuf, int size, int nonblock)
 {
     register struct tdb_read *cmd;
-    int ret;
+    struct tdb_cancel *ccmd;
+    int ret, cancel;
 
     debug_net("INET(%P) read sock %x size %d nonblock %d bufin %d\n",
            sock, size, nonblock, bufin_sem);
@@ -269,55 +303,74 @@ static int inet_read(struct socket *sock, char *ubuf, int size, int nonblock)
     if (size > TCPDEV_MAXREAD)
         size = TCPDEV_MAXREAD;
 
-    /* ensure read blocks until data - wait for ktcp to report data available*/
-    while (sock->avail_data == 0) {
+    if (sock->avail_data == 0) {
         /* return EOF on socket remote closed*/
         if (sock->flags & SF_CLOSING)
             return 0;
+        if (nonblock)
+            return -EAGAIN;
+    }
 
-        debug_net("INET(%P) read waiting on sock->avail_data sock %x buf_in %d\n",
-            sock, bufin_sem);
-
+    /* one read at a time per socket, wait interruptibly for another reader */
+    while (sock->flags & SF_READING) {
+        if (nonblock)
+            return -EAGAIN;
         interruptible_sleep_on(sock->wait);
         if (current->signal)
             return -EINTR;
     }
+    sock->flags |= SF_READING;
 
-    down(&rwlock);
-    cmd = (struct tdb_read *)get_tdout_buf();
+    cmd = (struct tdb_read *)get_tdout_buf(sizeof(struct tdb_read));
     cmd->cmd = TDC_READ;
     cmd->sock = sock;
     cmd->size = size;
     cmd->nonblock = nonblock;
+    sock->flags &= ~SF_RDREPLY;
     tcpdev_inetwrite(cmd, sizeof(struct tdb_read));
 
-    debug_net("INET(%P) read waiting on wait %x, bufin %d\n",
-        sock->wait, bufin_sem);
-
-    /* Sleep until tcpdev has news and we have a lock on the buffer */
-    while (bufin_sem == 0) {
-        debug_net("INET(%P) read WAIT sock %x bufin_sem\n", sock);
-        interruptible_sleep_on(sock->wait);
+    /*
+     * With no data available ktcp holds the read and replies when data
+     * arrives or the connection closes. On a signal the read is cancelled,
+     * after which ktcp replies with -EINTR, -EPIPE or the data. That reply
+     * comes on ktcp's next cycle, not when the peer sends, and must be
+     * waited for since a data reply holds tdin_buf until copied. A late
+     * second reply to the cancel is dropped by inet_process_tcpdev.
+     */
+    cancel = 0;
+    while (!(sock->flags & SF_RDREPLY)) {
+        debug_net("INET(%P) read waiting on wait %x\n", sock->wait);
+        if (cancel)
+            sleep_on(sock->wait);
+        else {
+            interruptible_sleep_on(sock->wait);
+            if (current->signal && !(sock->flags & SF_RDREPLY)) {
+                debug_net("INET(%P) read cancel sock %x\n", sock);
+                ccmd = (struct tdb_cancel *)get_tdout_buf(sizeof(struct tdb_cancel));
+                ccmd->cmd = TDC_CANCEL;
+                ccmd->sock = sock;
+                tcpdev_inetwrite(ccmd, sizeof(struct tdb_cancel));
+                cancel = 1;
+            }
+        }
     }
+    ret = sock->rdretval;
     debug_net("INET(%P) read wait done bufin_sem %d\n", bufin_sem);
 
-    down(&sock->sem);
-    ret = ((struct tdb_return_data *)tdin_buf)->ret_value;
-
     if (ret > 0) {
         debug_net("INET(%P) READ %u ask %u avail %u\n",
             ret, size, sock->avail_data);
 
+        /* data reply holds tdin_buf until copied */
         memcpy_tofs(ubuf, &((struct tdb_return_data *)tdin_buf)->data,
             (size_t) ((struct tdb_return_data *)tdin_buf)->size);
         sock->avail_data = 0;
+        tcpdev_clear_data_avail();
     } else debug_net("INET(%P) READ %d ask %u avail %u\n",
         ret, size, sock->avail_data);
 
-    up(&sock->sem);
-
-    tcpdev_clear_data_avail();
-    up(&rwlock);
+    sock->flags &= ~SF_READING;
+    wake_up(sock->wait);
     return ret;
 }
 
@@ -339,40 +392,34 @@ static int inet_write(register struct socket *sock, char *ubuf, int size,
 
     count = size;
     while (count) {
-        down(&rwlock);
-        cmd = (struct tdb_write *)get_tdout_buf();
+        usize = count > TDB_WRITE_MAX ? TDB_WRITE_MAX : count;
+        down(&sock->sem);
+        cmd = (struct tdb_write *)get_tdout_buf(TDB_WRITE_LEN(usize));
         cmd->cmd = TDC_WRITE;
         cmd->sock = sock;
         cmd->nonblock = nonblock;
-        cmd->size = count > TDB_WRITE_MAX ? TDB_WRITE_MAX : count;
+        cmd->size = usize;
 
         debug_net("INET(%P) WRITE %u\n", cmd->size);
 
-        memcpy_fromfs(cmd->data, ubuf, (size_t) cmd->size);
-        usize = cmd->size;
-        tcpdev_inetwrite(cmd, sizeof(struct tdb_write));
-
-        /* Sleep until tcpdev has news and we have a lock on the buffer */
-        while (bufin_sem == 0) {
-            debug_net("INET(%P) write WAIT sock %x\n", sock);
-            interruptible_sleep_on(sock->wait);
-        }
-        debug_net("INET(%P) write WAIT done bufin_sem %d\n", bufin_sem);
-
-        ret = ((struct tdb_return_data *)tdin_buf)->ret_value;
+        memcpy_fromfs(cmd->data, ubuf, (size_t) usize);
+        sock->flags &= ~SF_WRITABLE;
+        ret = inet_request(sock, cmd, TDB_WRITE_LEN(usize));
+        up(&sock->sem);
 
         debug_net("INET(%P) write retval %d\n", ret);
-        tcpdev_clear_data_avail();
-        up(&rwlock);
 
         if (ret < 0) {
-            if (ret == -ERESTARTSYS) {
-                /* delay process 100ms*/
-                current->state = TASK_INTERRUPTIBLE;
-                current->timeout = jiffies + (HZ / 10); /* 1/10 sec = 100ms*/
-                schedule();
-            } else
+            if (ret != -ERESTARTSYS)
                 return ret;
+            /* no send space, ktcp sends TDT_WRITABLE when some is freed */
+            if (nonblock)
+                return (count < size)? size - count: -EAGAIN;
+            while (!(sock->flags & SF_WRITABLE) && sock->state == SS_CONNECTED) {
+                interruptible_sleep_on(sock->wait);
+                if (current->signal)
+                    return (count < size)? size - count: -EINTR;
+            }
         }
         else {
             count -= usize;
@@ -97,6 +97,7 @@ static struct socket *sock_alloc(void)
 	0,		/* sem */
 	0,		/* avail_data */
 	0,		/* retval */
+	0,		/* rdretval */
 	0,		/* remaddr */
 	0,		/* localaddr */
 	0,		/* remport */
@@ -0,0 +1,241 @@
+/*
+ * kprof - control the kernel sampling profiler and report hot spots
+ *
+ * Usage on ELKS (kernel built with CONFIG_PROFILE):
+ *	kprof start | stop | free
+ *	kprof dump [file]		write histogram as text
+ *	kprof report [options] [dumpfile]
+ *
+ * On the host (kprof86) only report is available, for symbolizing a dump
+ * copied from the target against the kernel system.sym, or against an
+ * application linked with -maout-symtab.
+ *
+ * Report options:
+ *	-s symfile	kernel symbol table (default /lib/system.sym on ELKS)
+ *	-e exe		symbolize user samples against executable instead
+ *	-p pid		only count samples from pid
+ *	-a		report by address instead of function
+ *	-n count	number of lines to show (default 20)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "debug/syms.h"
+#ifdef __ia16__
+#include <sys/kprof.h>
+#endif
+
+#define MAXFUNCS	512	/* max distinct report lines */
+
+struct func {
+    char *name;
+    unsigned long count;
+};
+
+static struct func funcs[MAXFUNCS];
+static int nfuncs;
+static unsigned long total, other;
+
+#ifdef __ia16__
+static int dump(char *path)
+{
+    struct kprof_info info;
+    static struct kprof_sample buf[64];
+    FILE *fp = stdout;
+    int n, i;
+
+    if (kprof(KPROF_INFO, (char *)&info, sizeof(info)) < 0) {
+        perror("kprof");
+        return 1;
+    }
+    if (path && !(fp = fopen(path, "w"))) {
+        perror(path);
+        return 1;
+    }
+    fprintf(fp, "# kprof hz %u samples %lu lost %lu kernel_cs %04x fartext_cs %04x\n",
+        info.hz, info.samples, info.lost, info.kernel_cs, info.fartext_cs);
+    while ((n = kprof(KPROF_READ, (char *)buf, sizeof(buf))) > 0) {
+        for (i = 0; i < n / sizeof(struct kprof_sample); i++)
+            fprintf(fp, "%04x %04x %u %u\n", buf[i].cs, buf[i].ip, buf[i].pid,
+                buf[i].count);
+    }
+    if (n < 0)
+        perror("kprof");
+    if (path)
+        fclose(fp);
+    return n < 0;
+}
+#endif
+
+static void count(char *name, unsigned int n)
+{
+    struct func *f;
+
+    for (f = funcs; f < &funcs[nfuncs]; f++) {
+        if (!strcmp(f->name, name)) {
+            f->count += n;
+            return;
+        }
+    }
+    if (nfuncs >= MAXFUNCS || !(name = strdup(name))) {
+        other += n;
+        return;
+    }
+    f->name = name;
+    f->count = n;
+    nfuncs++;
+}
+
+static int cmpcount(const void *a, const void *b)
+{
+    const struct func *fa = a, *fb = b;
+
+    if (fa->count == fb->count)
+        return 0;
+    return fa->count < fb->count? 1: -1;
+}
+
+static void line(unsigned long n, char *name)
+{
+    unsigned long pct = total? n * 1000 / total: 0;
+
+    printf("%8lu %3lu.%lu%%  %s\n", n, pct / 10, pct % 10, name);
+}
+
+static int report(char *path, char *symfile, char *exe, int pidonly, int byaddr, int lines)
+{
+    FILE *fp = stdin;
+    unsigned int kcs = 0, fcs = 0, cs, ip, pid, n;
+    unsigned long samples = 0, lost = 0;
+    int i, havesyms = 0;
+    char *name;
+    char buf[80], addr[96];
+
+    if (path && !(fp = fopen(path, "r"))) {
+        perror(path);
+        return 1;
+    }
+    if (exe) {
+        if (!(havesyms = sym_read_exe_symbols(exe) != NULL))
+            fprintf(stderr, "%s: no symbol table\n", exe);
+    } else if (symfile) {
+        if (!(havesyms = sym_read_symbols(symfile) != NULL))
+            fprintf(stderr, "%s: can't read symbols\n", symfile);
+    }
+
+    while (fgets(buf, sizeof(buf), fp)) {
+        if (buf[0] == '#') {
+            sscanf(buf, "# kprof hz %*u samples %lu lost %lu kernel_cs %x fartext_cs %x",
+                &samples, &lost, &kcs, &fcs);
+            continue;
+        }
+        if (sscanf(buf, "%x %x %u %u", &cs, &ip, &pid, &n) != 4)
+            continue;
+        if (pidonly >= 0 && pid != pidonly)
+            continue;
+        total += n;
+        if (cs == kcs || (cs == fcs && fcs)) {
+            if (exe)
+                name = "[kernel]";
+            else if (cs == kcs)
+                name = sym_text_symbol((void *)(size_t)ip, byaddr? -1: 0);
+            else
+                name = sym_ftext_symbol((void *)(size_t)ip, byaddr? -1: 0);
+        } else if (exe) {
+            name = sym_text_symbol((void *)(size_t)ip, byaddr? -1: 0);
+        } else {
+            sprintf(buf, "[pid %u]", pid);
+            name = buf;
+        }
+        if (byaddr && name[0] != '[') {
+            if (havesyms)
+                sprintf(addr, "%04x:%04x %s", cs, ip, name);
+            else
+                sprintf(addr, "%04x:%04x", cs, ip);
+            name = addr;
+        }
+        count(name, n);
+    }
+    if (path)
+        fclose(fp);
+
+    qsort(funcs, nfuncs, sizeof(struct func), cmpcount);
+    printf("%lu samples, %lu recorded, %lu lost\n", samples, total, lost);
+    for (i = 0; i < nfuncs && i < lines; i++)
+        line(funcs[i].count, funcs[i].name);
+    for (; i < nfuncs; i++)
+        other += funcs[i].count;
+    if (other)
+        line(other, "[other]");
+    return 0;
+}
+
+static void usage(void)
+{
+#ifdef __ia16__
+    fprintf(stderr, "Usage: kprof start | stop | free | dump [file]\n"
+            "       kprof report [-s symfile] [-e exe] [-p pid] [-a] [-n count] [dumpfile]\n");
+#else
+    fprintf(stderr, "Usage: kprof86 [-s symfile] [-e exe] [-p pid] [-a] [-n count] [dumpfile]\n");
+#endif
+    exit(1);
+}
+
+int main(int ac, char **av)
+{
+    char *symfile = NULL, *exe = NULL;
+    int pid = -1, byaddr = 0, lines = 20;
+    int ch;
+
+#ifdef __ia16__
+    int op = 0;
+
+    if (ac < 2)
+        usage();
+    if (!strcmp(av[1], "start"))
+        op = KPROF_START;
+    else if (!strcmp(av[1], "stop"))
+        op = KPROF_STOP;
+    else if (!strcmp(av[1], "free"))
+        op = KPROF_FREE;
+    else if (!strcmp(av[1], "dump"))
+        return dump(av[2]);
+    else if (strcmp(av[1], "report"))
+        usage();
+    if (op) {
+        if (kprof(op, NULL, 0) < 0) {
+            perror("kprof");
+            return 1;
+        }
+        return 0;
+    }
+    ac--;
+    av++;
+    symfile = "/lib/system.sym";
+#endif
+
+    while ((ch = getopt(ac, av, "s:e:p:an:")) != -1) {
+        switch (ch) {
+        case 's':
+            symfile = optarg;
+            break;
+        case 'e':
+            exe = optarg;
+            break;
+        case 'p':
+            pid = atoi(optarg);
+            break;
+        case 'a':
+            byaddr = 1;
+            break;
+        case 'n':
+            lines = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    return report(av[optind], symfile, exe, pid, byaddr, lines);
+}
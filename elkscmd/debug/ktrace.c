@@ -0,0 +1,180 @@
+/*
+ * ktrace - control and decode the kernel event trace ring
+ *
+ * Usage (kernel built with CONFIG_KTRACE):
+ *	ktrace start [classes]	clear ring and trace classes (default all)
+ *	ktrace stop		stop tracing, leaving ring for display
+ *	ktrace off		stop tracing and free ring
+ *	ktrace [-n count]	display last count events (default all)
+ *
+ * Classes are letters: s sched, i irq, b block I/O, c buffer cache, n net.
+ * Tracing can also be started with sysctl kern.ktrace=mask.
+ */
+#define __LIBC__            /* get all typedefs */
+#include <linuxmt/types.h>
+#include <linuxmt/mem.h>
+#include <linuxmt/ktrace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/sysctl.h>
+
+#define LINEARADDRESS(off, seg)     ((off_t) (((off_t)seg << 4) + off))
+#define PTICKS_PER_MS   1193
+
+static struct ktrace_event ring[KTRACE_ENTRIES];
+
+static const char classes[] = "sibcn";  /* KTC_* bit order */
+
+static const char *names[] = {
+    "switch", 0,      0,       0,       /* 0x0? */
+    "irq",    "irqdone", 0,    0,       /* 0x1? */
+    "bread",  "bwrite", "bdone", "berror", /* 0x2? */
+    "bhit",   "bmiss",  0,     0,       /* 0x3? */
+    "netrx",  "nettx",  0,     0,       /* 0x4? */
+};
+
+static int memread(int fd, word_t off, word_t seg, void *buf, int size)
+{
+    if (lseek(fd, LINEARADDRESS(off, seg), SEEK_SET) == -1)
+        return 0;
+    return read(fd, buf, size) == size;
+}
+
+/* convert pticks to usecs without overflow */
+static unsigned long usecs(unsigned long pticks)
+{
+    return pticks / PTICKS_PER_MS * 1000 + (pticks % PTICKS_PER_MS) * 1000 / PTICKS_PER_MS;
+}
+
+static void show(struct ktrace_event *e, unsigned long us, unsigned long dus)
+{
+    unsigned int t = e->type;
+    const char *name = 0;
+
+    if ((t >> 4) < 5 && (t & 15) < 4)
+        name = names[(t >> 4) * 4 + (t & 15)];
+    printf("%6lu.%03lu %7lu %5u ", us / 1000, us % 1000, dus, e->pid);
+    if (!name) {
+        printf("type %02x %u %lu\n", t, e->arg1, e->arg2);
+        return;
+    }
+    printf("%-8s", name);
+    switch (t >> 4) {
+    case 0:
+        printf("%u -> %lu\n", e->arg1, e->arg2);
+        break;
+    case 2:
+    case 3:
+        printf("dev %04x block %lu\n", e->arg1, e->arg2);
+        break;
+    default:
+        printf("%u\n", e->arg1);
+    }
+}
+
+static int dump(int count)
+{
+    struct ktrace_info info;
+    unsigned long n, first, done, t, prev = 0, start = 0, i;
+    unsigned int ds, off;
+    int fd, valid;
+
+    if ((fd = open("/dev/kmem", O_RDONLY)) < 0) {
+        perror("/dev/kmem");
+        return 1;
+    }
+    if (ioctl(fd, MEM_GETDS, &ds) || ioctl(fd, MEM_GETKTRACE, &off)) {
+        fprintf(stderr, "ktrace: kernel not built with CONFIG_KTRACE\n");
+        return 1;
+    }
+    if (!memread(fd, off, ds, &info, sizeof(info)) || !info.seg) {
+        fprintf(stderr, "ktrace: not started\n");
+        return 1;
+    }
+    n = info.count;
+    if (!memread(fd, 0, info.seg, ring, sizeof(ring)) ||
+        !memread(fd, off, ds, &done, sizeof(done))) {
+        perror("ktrace");
+        return 1;
+    }
+    close(fd);
+
+    /* skip entries overwritten while ring was being read */
+    valid = KTRACE_ENTRIES - (done - n);
+    if (valid < 0)
+        valid = 0;
+    if (n > valid)
+        first = n - valid;
+    else
+        first = 0;
+    if (count && n - first > count)
+        first = n - count;
+
+    printf("%lu events\n    time ms   delta   pid event\n", n);
+    for (i = first; i < n; i++) {
+        struct ktrace_event *e = &ring[(unsigned)i & (KTRACE_ENTRIES - 1)];
+
+        t = e->jiffies * info.reload + e->pit;
+        /* PIT wrapped but timer interrupt not yet counted in jiffies */
+        if (i != first && t < prev && prev - t < info.reload)
+            t += info.reload;
+        if (i == first)
+            start = prev = t;
+        show(e, usecs(t - start), usecs(t - prev));
+        prev = t;
+    }
+    return 0;
+}
+
+static int control(char *s, int mask)
+{
+    char *p;
+
+    if (s) {
+        for (; *s; s++) {
+            if (!(p = strchr(classes, *s))) {
+                fprintf(stderr, "ktrace: unknown class '%c'\n", *s);
+                return 1;
+            }
+            mask |= 1 << (p - classes);
+        }
+    }
+    if (sysctl(CTL_SET, "kern.ktrace", &mask) < 0) {
+        perror("kern.ktrace");
+        return 1;
+    }
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: ktrace start [sibcn] | stop | off | [-n count]\n");
+    exit(1);
+}
+
+int main(int ac, char **av)
+{
+    int count = 0;
+    int ch;
+
+    if (ac >= 2 && !strcmp(av[1], "start"))
+        return control(av[2]? av[2]: (char *)classes, 0);
+    if (ac == 2 && !strcmp(av[1], "stop"))
+        return control(NULL, KTC_KEEP);
+    if (ac == 2 && !strcmp(av[1], "off"))
+        return control(NULL, 0);
+    while ((ch = getopt(ac, av, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            count = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    return dump(count);
+}
@@ -22,13 +22,16 @@
 #include <errno.h>
 #include <dirent.h>
 #include <limits.h>
+#include "futils.h"
 
-#define BUF_SIZE	BUFSIZ		/* use disk block size for stack limit and efficiency*/
+#define BUF_SIZE	BUFSIZ		/* smallest copy buffer, disk block size */
+#define MAX_BUF_SIZE	16384		/* largest, leaves heap for -R lists */
 
 int opt_recurse;	/* implicitly initialized */
 int opt_verbose;
 int opt_nocopyzero;
 int opt_force;
+int opt_sparse;
 int whole_disk_copy;
 char *destination_dir;
 
@@ -45,7 +48,8 @@ int copyfile(char *srcname, char *destname, int setmodes);
 #define MAJOR_SHIFT	8
 #endif
 
-static char buf[BUF_SIZE];
+static char *buf;
+static int bufsize;
 
 struct list_node_s {
 	struct list_node_s *prev;
@@ -528,6 +532,17 @@ int isadir(char *name)
 	return S_ISDIR(statbuf.st_mode);
 }
 
+/* allocate the largest copy buffer the heap allows, once */
+static int getbuf(void)
+{
+	for (bufsize = MAX_BUF_SIZE; bufsize >= BUF_SIZE; bufsize >>= 1) {
+		if ((buf = malloc(bufsize)) != NULL)
+			return 0;
+	}
+	fprintf(stderr, "cp: out of memory\n");
+	return 1;
+}
+
 /*
  * Copy one file to another, while possibly preserving its modes, times,
  * and modes.  Returns 0 if successful, or 1 on a failure with an
@@ -539,8 +554,7 @@ int copyfile(char *srcname, char *destname, int setmodes)
 	int		rfd;
 	int		wfd;
 	int		rcc;
-	int		wcc;
-	char		*bp;
+	int		sparse;
 	struct	stat	statbuf1;
 	struct	stat	statbuf2;
 	struct	utimbuf	times;
@@ -562,6 +576,9 @@ int copyfile(char *srcname, char *destname, int setmodes)
 		return 1;
 	}
 
+	if (!buf && getbuf())
+		return 1;
+
 	rfd = open(srcname, 0);
 	if (rfd < 0) {
 		perror(srcname);
@@ -581,16 +598,11 @@ int copyfile(char *srcname, char *destname, int setmodes)
 		}
 	}
 
-	while ((rcc = read(rfd, buf, BUF_SIZE)) > 0) {
-		bp = buf;
-		while (rcc > 0) {
-			wcc = write(wfd, bp, rcc);
-			if (wcc < 0) {
-				perror(destname);
-				goto error_exit;
-			}
-			bp += wcc;
-			rcc -= wcc;
+	sparse = opt_sparse && sparse_ok(wfd);
+	while ((rcc = read(rfd, buf, bufsize)) > 0) {
+		if (sparse_write(wfd, buf, rcc, sparse) < 0) {
+			perror(destname);
+			goto error_exit;
 		}
 	}
 
@@ -599,6 +611,11 @@ int copyfile(char *srcname, char *destname, int setmodes)
 		goto error_exit;
 	}
 
+	if (sparse_finish(wfd) < 0) {
+		perror(destname);
+		goto error_exit;
+	}
+
 	close(rfd);
 	close(wfd);
 
@@ -623,7 +640,7 @@ error_exit:
 
 void usage(void)
 {
-	fprintf(stderr, "usage: cp [-R][-v] source [...] target_file_or_directory\n");
+	fprintf(stderr, "usage: cp [-R][-v][-f][-S] source [...] target_file_or_directory\n");
 	exit(1);
 }
 
@@ -643,6 +660,8 @@ int main(int argc, char **argv)
 			    opt_verbose = 1;
 		    else if (*p == 'f')
 			    opt_force = 1;
+		    else if (*p == 'S')
+			    opt_sparse = 1;
 		    else usage();
         }
 		argv++;
@@ -23,6 +23,7 @@
 #define	PAR_COUNT	4
 #define	PAR_SEEK	5
 #define	PAR_SKIP	6
+#define	PAR_CONV	7
 
 
 struct param {
@@ -37,11 +38,13 @@ static struct param params[] = {
 	{ "count",	PAR_COUNT },
 	{ "seek",	PAR_SEEK },
 	{ "skip",	PAR_SKIP },
+	{ "conv",	PAR_CONV },
 	{ NULL,		PAR_NONE }
 };
 
-/* Fixed buffer */
-static char localbuf[BUFSIZ];		/* use disk block size for efficiency*/
+#define MAXBUF		32767U		/* largest read(), rounded down to whole blocks */
+
+static int sparse;		/* seek over zero blocks instead of writing them */
 
 /*
  * Read a number with a possible multiplier.
@@ -124,8 +127,9 @@ int main(int argc, char **argv)
 	int	infd;
 	int	outfd;
 	int	incc = 0;
-	int	outcc;
+	long	outcc;
 	int	blocksize;
+	unsigned int	bufsize;
 	long	count = -1;
 	long	seekval;
 	long	skipval;
@@ -206,6 +210,14 @@ int main(int argc, char **argv)
 				}
 				break;
 
+			case PAR_CONV:
+				if (strcmp(cp, "sparse") != 0) {
+					errmsg("Unknown conv value\n");
+					goto usage;
+				}
+				sparse = 1;
+				break;
+
 			default:
 				errmsg("Unknown dd parameter\n");
 				goto usage;
@@ -220,13 +232,21 @@ int main(int argc, char **argv)
 		outfile = "-";
 	}
 
-	buf = localbuf;
-	if (blocksize > sizeof(localbuf)) {
-		buf = malloc(blocksize);
-		if (buf == NULL) {
-			errmsg("Cannot allocate buffer\n");
-			return retval;
-		}
+	/*
+	 * Read and write as many whole blocks at once as the heap allows,
+	 * the byte counts and so the records reported are unchanged.
+	 */
+	bufsize = blocksize;
+	if (bufsize < MAXBUF)
+		bufsize = MAXBUF / bufsize * bufsize;
+	while ((buf = malloc(bufsize)) == NULL && bufsize > blocksize) {
+		bufsize = bufsize / 2 / blocksize * blocksize;
+		if (bufsize < blocksize)
+			bufsize = blocksize;
+	}
+	if (buf == NULL) {
+		errmsg("Cannot allocate buffer\n");
+		return retval;
 	}
 
 	if (!strcmp(infile, "-"))  {
@@ -275,6 +295,9 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (sparse && !sparse_ok(outfd))
+		sparse = 0;
+
 	/* If count is specified, only copy that many blocks */
 	if (count > 0)
 		count *= blocksize;
@@ -283,21 +306,25 @@ int main(int argc, char **argv)
 	else
 		goto cleanup;	/* exit immediately if count == 0 */
 
-	while ((count > intotal) && (incc = read(infd, buf, blocksize)) > 0) {
+	while (count > intotal) {
+		incc = bufsize;
+		if (count - intotal < incc)
+			incc = count - intotal;
+		if ((incc = read(infd, buf, incc)) <= 0)
+			break;
 		intotal += incc;
-		cp = buf;
-
-		while (incc > 0) {
-			outcc = write(outfd, cp, incc);
-			if (outcc < 0) {
-				perror(outfile);
-				goto cleanup;
-			}
 
-			outtotal += outcc;
-			cp += outcc;
-			incc -= outcc;
+		outcc = sparse_write(outfd, buf, incc, sparse);
+		if (outcc < 0) {
+			perror(outfile);
+			goto cleanup;
 		}
+		outtotal += outcc;
+	}
+
+	if (sparse_finish(outfd) < 0) {
+		perror(outfile);
+		goto cleanup;
 	}
 
 	/* Exit status can only become 0 (no error) at this point */
@@ -311,7 +338,7 @@ cleanup:
 cleanup2:
 	close(infd);
 cleanup3:
-	if (buf != localbuf) free(buf);
+	free(buf);
 
 	/* %ld+%ld records in */
 	eprintf(ultoa_r(b1, intotal / blocksize), "+",
@@ -329,6 +356,6 @@ cleanup3:
 	return retval;
 
 usage:
-	errmsg("usage: dd [if=file][of=file][bs=N][count=N][seek=N][skip=N]\n");
+	errmsg("usage: dd [if=file][of=file][bs=N][count=N][seek=N][skip=N][conv=sparse]\n");
 	return 1;
 }
@@ -12,3 +12,8 @@
 
 #define errmsg(str) write(STDERR_FILENO, str, sizeof(str) - 1)
 #define errstr(str) write(STDERR_FILENO, str, strlen(str))
+
+/* sparse.c */
+int sparse_ok(int fd);
+int sparse_write(int fd, char *buf, int len, int sparse);
+int sparse_finish(int fd);
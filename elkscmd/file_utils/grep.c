@@ -13,68 +13,60 @@
 #include <string.h>
 #include <ctype.h>
 
+static unsigned int	skip[256];	/* Boyer-Moore-Horspool shift table */
+static unsigned char	fold[256];	/* identity, or lower case for -i */
+
 /*
- * See if the specified word is found in the specified string.
+ * Set up for searching for the word, folding it to lower case if
+ * case is to be ignored.
  */
-static int search(char *string, char *word, int ignorecase)
+static void prepare(char *word, int ignorecase)
 {
-	char	*cp1;
-	char	*cp2;
 	int	len;
-	int	lowfirst;
-	int	ch1;
-	int	ch2;
-
-	len = strlen(word);
-
-	if (!ignorecase) {
-		while (1) {
-			string = strchr(string, word[0]);
-			if (string == NULL)
-				return 0;
-
-			if (memcmp(string, word, len) == 0)
-				return 1;
+	int	i;
 
-			string++;
-		}
-	}
-
-	/*
-	 * Here if we need to check case independence.
-	 * Do the search by lower casing both strings.
-	 */
-	lowfirst = *word;
-	if (isupper(lowfirst))
-		lowfirst = tolower(lowfirst);
+	for (i = 0; i < 256; i++)
+		fold[i] = ignorecase ? tolower(i) : i;
 
-	while (1) {
-		while (*string && (*string != lowfirst) &&
-			(!isupper(*string) || (tolower(*string) != lowfirst)))
-				string++;
-
-		if (*string == '\0')
-			return 0;
-
-		cp1 = string;
-		cp2 = word;
+	len = strlen(word);
+	for (i = 0; i < len; i++)
+		word[i] = fold[(unsigned char)word[i]];
+
+	for (i = 0; i < 256; i++)
+		skip[i] = len;
+	for (i = 0; i < len - 1; i++)
+		skip[(unsigned char)word[i]] = len - 1 - i;
+	for (i = 0; i < 256; i++)
+		skip[i] = skip[fold[i]];
+}
 
-		do {
-			if (*cp2 == '\0')
+/*
+ * See if the specified word is found in the specified string of length
+ * slen, by comparing the last character of the word first and shifting
+ * by as much as possible on a mismatch.
+ */
+static int search(char *string, int slen, char *word, int len)
+{
+	unsigned char	*cp;
+	unsigned char	*end;
+	unsigned char	*wp = (unsigned char *)word;
+	int	last = len - 1;
+	int	i;
+
+	if (len == 0)
+		return 1;
+	if (slen < len)
+		return 0;
+
+	cp = (unsigned char *)string;
+	end = cp + slen - last;
+	while (cp < end) {
+		for (i = last; fold[cp[i]] == wp[i]; i--)
+			if (i == 0)
 				return 1;
-
-			ch1 = *cp1++;
-			if (isupper(ch1))
-				ch1 = tolower(ch1);
-
-			ch2 = *cp2++;
-			if (isupper(ch2))
-				ch2 = tolower(ch2);
-
-		} while (ch1 == ch2);
-
-		string++;
+		cp += skip[cp[last]];
 	}
+	return 0;
 }
 
 
@@ -87,6 +79,8 @@ int main(int argc, char **argv)
 	int	tellname;
 	int	ignorecase;
 	int	tellline;
+	int	wordlen;
+	int	len;
 	long	line;
 	char	buf[BUFSIZ];
 
@@ -120,6 +114,9 @@ int main(int argc, char **argv)
 	word = *argv++;
 	argc--;
 
+	prepare(word, ignorecase);
+	wordlen = strlen(word);
+
 	tellname = (argc > 1);
 
 	while (argc-- > 0) {
@@ -137,10 +134,11 @@ int main(int argc, char **argv)
 			line++;
 
 			/* Make sure the data is text and didn't overflow */
-			cp = &buf[strlen(buf) - 1];
+			len = strlen(buf);
+			cp = &buf[len - 1];
 			if (*cp != '\n') goto error_line_length;
 
-			if (search(buf, word, ignorecase)) {
+			if (search(buf, len - 1, word, wordlen)) {
 				if (tellname)
 					printf("%s: ", name);
 				if (tellline)
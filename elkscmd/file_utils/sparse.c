@@ -0,0 +1,95 @@
+/*
+ * Sparse output for cp and dd
+ *
+ * Runs of zero blocks are skipped with lseek instead of being written,
+ * leaving holes that read back as zeros. A trailing hole is ended by
+ * writing its last byte so the file gets its full size.
+ */
+#include "futils.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define ZBLOCK		1024		/* sparse test unit, disk block size */
+
+static int hole;		/* output currently ends in a hole */
+
+static int iszero(char *p, int n)
+{
+	while (n > 0 && !*p) {
+		p++;
+		n--;
+	}
+	return n == 0;
+}
+
+/*
+ * Return 1 if holes can be left in fd: only regular files read holes back
+ * as zeros, and with O_APPEND every write goes to the end, ignoring lseek.
+ */
+int sparse_ok(int fd)
+{
+	struct stat st;
+	int flags;
+
+	hole = 0;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+		return 0;
+	flags = fcntl(fd, F_GETFL);
+	return flags != -1 && !(flags & O_APPEND);
+}
+
+/*
+ * Write len bytes, seeking over runs of zero blocks when sparse.
+ * Returns bytes written or skipped, -1 on error.
+ */
+int sparse_write(int fd, char *buf, int len, int sparse)
+{
+	int total = 0;
+	int n, cc;
+
+	while (len > 0) {
+		n = len;
+		if (sparse) {
+			for (n = 0; n < len && iszero(buf + n, len - n < ZBLOCK? len - n: ZBLOCK);
+				n += ZBLOCK)
+				continue;
+			if (n > len)
+				n = len;
+			if (n) {
+				if (lseek(fd, (long)n, SEEK_CUR) < 0)
+					return -1;
+				hole = 1;
+				buf += n;
+				len -= n;
+				total += n;
+				continue;
+			}
+			for (n = ZBLOCK; n < len && !iszero(buf + n, len - n < ZBLOCK? len - n: ZBLOCK);
+				n += ZBLOCK)
+				continue;
+			if (n > len)
+				n = len;
+		}
+		cc = write(fd, buf, n);
+		if (cc < 0)
+			return -1;
+		hole = 0;
+		buf += cc;
+		len -= cc;
+		total += cc;
+	}
+	return total;
+}
+
+/* write the last byte of a trailing hole to set the file size, -1 on error */
+int sparse_finish(int fd)
+{
+	if (!hole)
+		return 0;
+	hole = 0;
+	if (lseek(fd, -1L, SEEK_CUR) < 0 || write(fd, "", 1) != 1)
+		return -1;
+	return 0;
+}
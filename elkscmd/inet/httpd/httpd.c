@@ -35,14 +35,53 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/wait.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <time.h>
 
 #define DEF_PORT		80
 #define DEF_CONTENT	"text/html"
 
+#define MAX_CLIENTS	4		/* concurrent connections in select mode */
+#define REQ_SIZE	512		/* request header buffer per client */
+#define BUF_SIZE	4096		/* file transfer chunk size */
+#define KEEPALIVE_SECS	10		/* close idle keep-alive connections */
+#define ACCEPT_POLL_MS	250		/* check for new connections while serving */
+
+#define CACHE_ENTRIES	4		/* in-memory cache of small files */
+#define CACHE_MAXFILE	2048
+
 #define WS(c)	( ((c) == ' ') || ((c) == '\t') || ((c) == '\r') || ((c) == '\n') )
 
+struct cache {
+	char *path;
+	char *data;
+	off_t size;
+	time_t mtime;
+	unsigned int lastuse;
+	int users;		/* clients sending from data, not replaceable */
+};
+
+struct client {
+	int fd;			/* socket, -1 if slot free */
+	int sending;		/* request read, sending response */
+	int keepalive;
+	int file;		/* file being sent, -1 if none */
+	struct cache *cp;	/* cached file being sent */
+	long off;
+	long left;		/* bytes left to send */
+	time_t last;		/* time of last activity */
+	int len;		/* request bytes read */
+	int hdrlen;		/* request header length, rest is next request */
+	char req[REQ_SIZE];
+};
+
 int listen_sock;
-char buf[1536];
+char buf[BUF_SIZE];
+struct client clients[MAX_CLIENTS];
+struct cache cache[CACHE_ENTRIES];
+unsigned int cache_clock;
+int forkmode;
 
 char* get_mime_type(char *name)
 {
@@ -68,45 +107,178 @@ char* get_mime_type(char *name)
     return "text/plain";
 }
 
-void send_header(int fd, char *ct)
+/* send header in a single write, so it goes out as one segment */
+void send_header(int fd, char *ct, off_t size, int keepalive)
 {
-	buf[0] = 0;
-	sprintf(buf, "HTTP/1.0 200 OK\r\nServer: nanoHTTPd/0.1\r\nDate: Thu Apr 26 15:37:46 GMT 2001\r\nContent-Type: %s\r\n",ct);
+	sprintf(buf, "HTTP/1.0 200 OK\r\nServer: nanoHTTPd/0.1\r\nDate: Thu Apr 26 15:37:46 GMT 2001\r\n"
+		"Content-Type: %s\r\nContent-Length: %ld\r\nConnection: %s\r\n\r\n",
+		ct, size, keepalive? "keep-alive": "close");
 	write(fd, buf, strlen(buf));
 }
 
 void send_error(int fd, int errnum, char *str)
 {
-	sprintf(buf,"HTTP/1.0 %d %s\r\nContent-type: %s\r\n", errnum, str, DEF_CONTENT);
-	write(fd, buf, strlen(buf));
-	sprintf(buf,"Connection: close\r\nDate: Thu Apr 26 15:37:46 GMT 2001\r\n\r\n%s\r\n",str);
+	sprintf(buf,"HTTP/1.0 %d %s\r\nContent-type: %s\r\n"
+		"Connection: close\r\nDate: Thu Apr 26 15:37:46 GMT 2001\r\n\r\n%s\r\n",
+		errnum, str, DEF_CONTENT, str);
 	write(fd, buf, strlen(buf));
 }
 
-void process_request(int fd)
+/*
+ * Return cached copy of small file, loading it if not present or stale.
+ * The caller holds a reference until cache_put, entries being sent
+ * are never replaced.
+ */
+struct cache *cache_get(char *path, struct stat *st)
 {
-	int fin, ret;
-	off_t size;
+	struct cache *cp, *victim = NULL;
+	int fd, stale = 0;
+
+	cache_clock++;
+	for (cp = cache; cp < &cache[CACHE_ENTRIES]; cp++) {
+		if (cp->path && !strcmp(cp->path, path)) {
+			if (cp->mtime == st->st_mtime && cp->size == st->st_size) {
+				cp->lastuse = cache_clock;
+				cp->users++;
+				return cp;
+			}
+			if (!cp->users) {
+				victim = cp;	/* reload stale copy in place */
+				stale = 1;
+			}
+			continue;
+		}
+		if (cp->users || stale)
+			continue;
+		if (!victim || !cp->path || (victim->path && cp->lastuse < victim->lastuse))
+			victim = cp;
+	}
+
+	if (!victim || st->st_size > CACHE_MAXFILE)
+		return NULL;
+
+	cp = victim;
+	free(cp->path);
+	free(cp->data);
+	cp->path = NULL;
+	cp->data = malloc(st->st_size? st->st_size: 1);
+	if (!cp->data)
+		return NULL;
+	if ((fd = open(path, O_RDONLY)) < 0)
+		goto fail;
+	if (read(fd, cp->data, st->st_size) != st->st_size) {
+		close(fd);
+		goto fail;
+	}
+	close(fd);
+	if (!(cp->path = strdup(path)))
+		goto fail;
+	cp->size = st->st_size;
+	cp->mtime = st->st_mtime;
+	cp->lastuse = cache_clock;
+	cp->users = 1;
+	return cp;
+
+fail:
+	free(cp->data);
+	cp->data = NULL;
+	return NULL;
+}
+
+/* release cached file reference */
+void cache_put(struct client *cl)
+{
+	if (cl->cp) {
+		cl->cp->users--;
+		cl->cp = NULL;
+	}
+}
+
+void client_close(struct client *cl)
+{
+	cache_put(cl);
+	if (cl->file >= 0)
+		close(cl->file);
+	close(cl->fd);
+	cl->fd = -1;
+}
+
+/* done with response, close or wait for next request */
+void client_done(struct client *cl)
+{
+	if (cl->file >= 0) {
+		close(cl->file);
+		cl->file = -1;
+	}
+	cache_put(cl);
+	cl->sending = 0;
+	if (!cl->keepalive) {
+		client_close(cl);
+		return;
+	}
+	/* keep pipelined bytes received after the header */
+	cl->len -= cl->hdrlen;
+	memmove(cl->req, cl->req + cl->hdrlen, cl->len);
+	cl->hdrlen = 0;
+}
+
+/* return 1 if complete request header read */
+int request_complete(struct client *cl)
+{
+	char *p, *q;
+
+	cl->req[cl->len] = 0;
+	p = strstr(cl->req, "\r\n\r\n");
+	q = strstr(cl->req, "\n\n");
+	if (q && (!p || q < p))
+		cl->hdrlen = q - cl->req + 2;
+	else if (p)
+		cl->hdrlen = p - cl->req + 4;
+	else if (cl->len >= REQ_SIZE - 1) {
+		cl->hdrlen = cl->len;
+		cl->keepalive = 0;	/* unread headers would be taken as next request */
+	} else
+		return 0;
+	return 1;
+}
+
+/* parse request and start response */
+void process_request(struct client *cl)
+{
+	int fd = cl->fd;
 	char *c, *file, fullpath[PATH_MAX];
 	struct stat st;
-	
-	ret = read(fd, buf, sizeof(buf));
-	
-	c = buf;
-	while (*c && !WS(*c) && c < (buf + sizeof(buf))){
-		c++;
+	int overflow = (cl->hdrlen == cl->len && cl->len >= REQ_SIZE - 1);
+	char save = cl->req[cl->hdrlen];
+
+	cl->req[cl->hdrlen] = 0;	/* don't parse pipelined request */
+
+	/* HTTP/1.1 defaults to keep-alive, HTTP/1.0 must ask for it */
+	cl->keepalive = strstr(cl->req, "HTTP/1.1") != NULL;
+	if ((c = strstr(cl->req, "Connection:")) || (c = strstr(cl->req, "connection:"))) {
+		c += 11;
+		while (*c == ' ')
+			c++;
+		cl->keepalive = !strncasecmp(c, "keep-alive", 10);
 	}
+	if (overflow || forkmode)
+		cl->keepalive = 0;
+
+	c = cl->req;
+	while (*c && !WS(*c))
+		c++;
 	*c = 0;
 	
-	if (strcasecmp(buf, "get")){
+	if (strcasecmp(cl->req, "get")){
 		send_error(fd, 404, "Method not supported");
-		return;		
+		cl->keepalive = 0;
+		client_done(cl);
+		return;
 	}
 	
 	file = ++c;
-	while (*c && !WS(*c) && c < (buf + sizeof(buf))){
+	while (*c && !WS(*c))
 		c++;
-	}
 	*c = 0;
 
 	/* TODO : Use strncat when security is the only problem of this server! */
@@ -114,38 +286,272 @@ void process_request(int fd)
 	strcat(fullpath, file);
 	
 	if (!stat(fullpath, &st) && (st.st_mode & S_IFMT) == S_IFDIR) {
-		if (file[strlen(fullpath) - 1] != '/'){
+		if (fullpath[strlen(fullpath) - 1] != '/'){
 			strcat(fullpath, "/");
 		}
 		strcat(fullpath, "index.html");
 	}
 	
-	fin = open(fullpath, O_RDONLY);
-	if (fin < 0){
+	if (stat(fullpath, &st) < 0 || (st.st_mode & S_IFMT) != S_IFREG) {
 		send_error(fd, 404, "Document (probably) not found");
+		cl->keepalive = 0;
+		client_done(cl);
 		return;
 	}
-	size = lseek(fin, (off_t)0, SEEK_END);
-	lseek(fin, (off_t)0, SEEK_SET);
-	send_header(fd, get_mime_type(fullpath));
-	sprintf(buf,"Content-Length: %ld\r\n\r\n", size);
-	write(fd, buf, strlen(buf));
-	
+
+	cl->off = 0;
+	cl->left = st.st_size;
+	cl->cp = cache_get(fullpath, &st);
+	if (!cl->cp) {
+		cl->file = open(fullpath, O_RDONLY);
+		if (cl->file < 0) {
+			send_error(fd, 404, "Document (probably) not found");
+			cl->keepalive = 0;
+			client_done(cl);
+			return;
+		}
+	}
+	send_header(fd, get_mime_type(fullpath), st.st_size, cl->keepalive);
+	cl->sending = 1;
+	cl->req[cl->hdrlen] = save;
+}
+
+/* send next chunk of response, return < 0 on error */
+int send_chunk(struct client *cl)
+{
+	int n = cl->left > BUF_SIZE? BUF_SIZE: (int)cl->left;
+	char *p;
+
+	if (cl->cp)
+		p = cl->cp->data + (unsigned int)cl->off;
+	else {
+		n = read(cl->file, buf, n);
+		if (n <= 0)
+			return -1;
+		p = buf;
+	}
+	if (write(cl->fd, p, n) != n)
+		return -1;
+	cl->off += n;
+	cl->left -= n;
+	return 0;
+}
+
+/* read request data from client */
+void client_read(struct client *cl)
+{
+	int ret;
+
+	ret = read(cl->fd, cl->req + cl->len, REQ_SIZE - 1 - cl->len);
+	if (ret <= 0) {
+		if (ret < 0 && errno == EAGAIN)
+			return;
+		client_close(cl);
+		return;
+	}
+	cl->len += ret;
+	if (request_complete(cl))
+		process_request(cl);
+}
+
+void client_write(struct client *cl)
+{
+	if (cl->left > 0 && send_chunk(cl) < 0) {
+		client_close(cl);
+		return;
+	}
+	if (cl->left <= 0) {
+		client_done(cl);
+		/* a pipelined request may already be complete */
+		if (cl->fd >= 0 && cl->len && request_complete(cl))
+			process_request(cl);
+	}
+}
+
+/* fork per connection: serve requests on one connection until closed */
+void serve_one(int fd)
+{
+	struct client *cl = &clients[0];
+
+	cl->fd = fd;
+	cl->file = -1;
+	cl->cp = NULL;
+	cl->len = 0;
+	cl->hdrlen = 0;
+	cl->sending = 0;
 	do {
-		ret = read(fin, buf, sizeof(buf));
-		if (ret > 0)
-			ret = write(fd, buf, ret);
-	} while (ret == sizeof(buf));
-	
-	close(fin);
-	
+		if (cl->sending)
+			client_write(cl);
+		else
+			client_read(cl);
+	} while (cl->fd >= 0);
 }
 
-int main(int argc, char **argv)
+void fork_loop(void)
 {
 	int ret, conn_sock;
+
+	while (1) {
+		conn_sock = accept(listen_sock, NULL, NULL);
+		
+		if (conn_sock < 0) {
+			if (errno == ENOTSOCK)
+				exit(1);
+			continue;
+		}
+
+		if ((ret = fork()) == -1)
+			perror("httpd");
+		else if (ret == 0) {
+			close(listen_sock);
+			serve_one(conn_sock);
+			exit(0);
+		} else {
+			close(conn_sock);
+			waitpid(ret, NULL, 0);
+		}
+	}
+}
+
+/* set listening socket blocking or not, only when changed */
+void listen_nonblock(int on)
+{
+	static int cur = -1;
+
+	if (on != cur) {
+		fcntl(listen_sock, F_SETFL, on? O_NONBLOCK: 0);
+		cur = on;
+	}
+}
+
+/* take new connection into free client slot */
+void client_add(int fd, time_t now)
+{
+	struct client *cl;
+
+	for (cl = clients; cl < &clients[MAX_CLIENTS]; cl++)
+		if (cl->fd < 0)
+			break;
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	cl->fd = fd;
+	cl->file = -1;
+	cl->cp = NULL;
+	cl->len = 0;
+	cl->hdrlen = 0;
+	cl->sending = 0;
+	cl->last = now;
+}
+
+/*
+ * Single process, serve multiple connections using select.
+ * A listening socket always selects readable, so it isn't selected on:
+ * with no connections open we sleep in a blocking accept, otherwise
+ * a non-blocking accept is tried each time round, at least every
+ * ACCEPT_POLL_MS while there is a free slot.
+ */
+void select_loop(void)
+{
+	struct client *cl;
+	fd_set rfds, wfds;
+	struct timeval tv;
+	int maxfd, nclients, fd;
+	time_t now;
+
+	for (cl = clients; cl < &clients[MAX_CLIENTS]; cl++)
+		cl->fd = -1;
+
+	while (1) {
+		FD_ZERO(&rfds);
+		FD_ZERO(&wfds);
+		maxfd = -1;
+		nclients = 0;
+		for (cl = clients; cl < &clients[MAX_CLIENTS]; cl++) {
+			if (cl->fd < 0)
+				continue;
+			if (cl->sending)
+				FD_SET(cl->fd, &wfds);
+			else
+				FD_SET(cl->fd, &rfds);
+			if (cl->fd > maxfd)
+				maxfd = cl->fd;
+			nclients++;
+		}
+
+		if (!nclients) {
+			listen_nonblock(0);
+			fd = accept(listen_sock, NULL, NULL);
+			if (fd < 0) {
+				if (errno == ENOTSOCK)
+					exit(1);
+				continue;
+			}
+			client_add(fd, time(NULL));
+			continue;
+		}
+
+		if (nclients < MAX_CLIENTS) {
+			tv.tv_sec = 0;
+			tv.tv_usec = ACCEPT_POLL_MS * 1000L;
+		} else {
+			tv.tv_sec = 1;		/* keep-alive timeouts */
+			tv.tv_usec = 0;
+		}
+		if (select(maxfd + 1, &rfds, &wfds, NULL, &tv) < 0) {
+			if (errno == EINTR)
+				continue;
+			exit(1);
+		}
+		now = time(NULL);
+
+		/* service existing connections round robin, one chunk each */
+		for (cl = clients; cl < &clients[MAX_CLIENTS]; cl++) {
+			if (cl->fd < 0)
+				continue;
+			if (FD_ISSET(cl->fd, &wfds))
+				client_write(cl);
+			else if (FD_ISSET(cl->fd, &rfds))
+				client_read(cl);
+			else if (!cl->sending && now - cl->last >= KEEPALIVE_SECS) {
+				client_close(cl);
+				nclients--;
+				continue;
+			} else
+				continue;
+			cl->last = now;
+		}
+
+		if (nclients < MAX_CLIENTS) {
+			listen_nonblock(1);
+			fd = accept(listen_sock, NULL, NULL);
+			if (fd >= 0)
+				client_add(fd, now);
+			else if (errno == ENOTSOCK)
+				exit(1);
+		}
+	}
+}
+
+void usage(void)
+{
+	fprintf(stderr, "Usage: httpd [-f]\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
 	struct sockaddr_in localadr;
 
+	while ((ret = getopt(argc, argv, "f")) != -1) {
+		switch (ret) {
+		case 'f':
+			forkmode = 1;	/* fork process per connection */
+			break;
+		default:
+			usage();
+		}
+	}
+
 	if ((listen_sock = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
 		perror("httpd");
 		return -1;
@@ -188,25 +594,9 @@ int main(int argc, char **argv)
 		close(ret);
 	setsid();
 
-	while (1) {
-		conn_sock = accept(listen_sock, NULL, NULL);
-		
-		if (conn_sock < 0) {
-			if (errno == ENOTSOCK)
-				exit(1);
-			continue;
-		}
-
-		if ((ret = fork()) == -1)
-			perror("httpd");
-		else if (ret == 0) {
-			close(listen_sock);
-			process_request(conn_sock);
-			close(conn_sock);
-			exit(0);
-		} else {
-			close(conn_sock);
-			waitpid(ret, NULL, 0);
-		}
-	}
+	if (forkmode)
+		fork_loop();
+	else
+		select_loop();
+	return 0;
 }
@@ -106,6 +106,7 @@ int main(int ac, char **av)
     printf("ICMP Packets     %7lu  ICMP Packets     %7lu\n", ns->icmprcvcnt, ns->icmpsndcnt);
     printf("SLIP Packets     %7lu  SLIP Packets     %7lu\n", ns->sliprcvcnt, ns->slipsndcnt);
     printf("ETH Packets      %7lu  ETH Packets      %7lu\n", ns->ethrcvcnt, ns->ethsndcnt);
+    printf("ETH Dropped      %7lu\n", ns->ethdropcnt);
     printf("ARP Reqs Sent    %7lu  ARP Replies Rcvd %7lu\n", ns->arpsndreqcnt, ns->arprcvreplycnt);
     printf("ARP Reqs Rcvd    %7lu  ARP Replies Sent %7lu\n", ns->arprcvreqcnt, ns->arpsndreplycnt);
     printf("ARP Cache Adds   %7lu\n", ns->arpcacheadds);
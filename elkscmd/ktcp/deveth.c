@@ -30,8 +30,17 @@
 
 eth_addr_t eth_local_addr;
 
-static unsigned char sbuf[MAX_PACKET_ETH];
+/*
+ * Packets per batched read. The driver only takes another packet while a
+ * full size one still fits, so each packet needs MAX_PACKET_ETH plus its
+ * length word however small it is.
+ */
+#define ETH_RXBATCH	4
+#define ETH_RXBUFSIZ	(ETH_RXBATCH * (MAX_PACKET_ETH + sizeof(unsigned short)))
+
+static unsigned char sbuf[ETH_RXBUFSIZ];
 static int devfd;
+static int eth_batch;		/* driver returns multiple packets per read*/
 
 //static eth_addr_t broad_addr = {255, 255, 255, 255, 255, 255};
 
@@ -52,6 +61,10 @@ int deveth_init(char *fdev)
 
         return -2;
     }
+
+    /* use batched reads if driver supports them */
+    eth_batch = (ioctl(devfd, IOCTL_ETH_RXBATCH_SET, 1) == 0);
+
     arp_gratuitous();	/* send gratuituous ARP to the net */
 
     return devfd;
@@ -59,18 +72,18 @@ int deveth_init(char *fdev)
 
 
 /*
- *  Called when select in ktcp indicates we have new data waiting
+ *  Dispatch a single received ethernet packet
  */
-void eth_process(void)
+static void eth_recvpacket(unsigned char *packet, int len)
 {
   eth_head_t * eth_head;
-  int len = read (devfd, sbuf, MAX_PACKET_ETH);
+
   if (len < (int)sizeof(eth_head_t)) {
-	if (len < 0) printf("ktcp: eth_process error %d (errno %d), discarding packet\n", len, errno); //FIXME
+	netstats.ethdropcnt++;
 	return;
   }
 
-  eth_head = (eth_head_t *) sbuf;
+  eth_head = (eth_head_t *) packet;
 
 #if 0
   /* Filter on MAC addresses in case of promiscuous mode*/
@@ -83,16 +96,53 @@ void eth_process(void)
   switch (eth_head->eth_type) {
   case ETH_TYPE_IPV4:
 	  /* strip link layer */
-	  ip_recvpacket (sbuf + sizeof(eth_head_t), len - sizeof(eth_head_t));
+	  ip_recvpacket (packet + sizeof(eth_head_t), len - sizeof(eth_head_t));
 	  break;
 
   case ETH_TYPE_ARP:
-	  arp_recvpacket (sbuf, len);
+	  arp_recvpacket (packet, len);
 	  break;
   }
   netstats.ethrcvcnt++;
 }
 
+/*
+ *  Called when select in ktcp indicates we have new data waiting
+ */
+void eth_process(void)
+{
+  unsigned char *p;
+  unsigned short size;
+  int len;
+
+  len = read (devfd, sbuf, eth_batch? ETH_RXBUFSIZ: MAX_PACKET_ETH);
+  if (len < (int)sizeof(eth_head_t)) {
+	netstats.ethdropcnt++;
+	if (len < 0) printf("ktcp: eth_process error %d (errno %d), discarding packet\n", len, errno); //FIXME
+	return;
+  }
+
+  if (!eth_batch) {
+	eth_recvpacket (sbuf, len);
+	return;
+  }
+
+  /* batched read: each packet preceded by its length*/
+  p = sbuf;
+  while (len >= (int)sizeof(size)) {
+	memcpy(&size, p, sizeof(size));
+	p += sizeof(size);
+	len -= sizeof(size);
+	if (size > len) {
+		netstats.ethdropcnt++;
+		break;
+	}
+	eth_recvpacket (p, size);
+	p += size;
+	len -= size;
+  }
+}
+
 /*
  * Determine ethernet address for IP packet using ARP request/cache
  * Packet will be sent if address cached, otherwise sent after ARP reply
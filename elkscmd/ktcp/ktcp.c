@@ -94,6 +94,9 @@ void ktcp_run(void)
 	    tv = NULL;		/* no timeout if no timers active or push needed */
 	}
 
+	/* send replies queued by last loop to kernel*/
+	tcpdev_flush();
+
 	FD_ZERO(&fdset);
 	FD_SET(intfd, &fdset);
 	FD_SET(tcpdevfd, &fdset);
@@ -39,6 +39,7 @@ struct packet_stats_s {
 
 	__u32	ethsndcnt;
 	__u32	ethrcvcnt;
+	__u32	ethdropcnt;	/* packet short, truncated or read failed*/
 	__u32	arprcvreplycnt;
 	__u32	arprcvreqcnt;
 	__u32	arpsndreplycnt;
@@ -39,6 +39,7 @@ static unsigned char	lastchar;
 static unsigned char 	packet[SLIP_MTU + 128];
 static unsigned int	packpos;
 static int devfd;
+static int slip_ldisc;		/* kernel does SLIP framing*/
 
 static speed_t convert_baudrate(speed_t baudrate)
 {
@@ -122,6 +123,10 @@ int slip_init(char *fdev, speed_t baudrate)
     tios.c_cc[VTIME] = 0;
     ioctl(devfd, TCSETS, &tios);
 
+    /* let serial driver frame packets if possible*/
+    slip_ldisc = N_SLIP;
+    slip_ldisc = (ioctl(devfd, TIOCSETD, &slip_ldisc) == 0);
+
     packpos = 128;
     lastchar = 0;
 
@@ -162,16 +167,39 @@ void cslip_decompress(__u8 **packet, size_t *len){
 }
 #endif
 
+/* pass received frame at packet+128 to IP*/
+static void slip_recvframe(size_t p_size)
+{
+    unsigned char *p;
+
+#if CSLIP
+    if (linkprotocol == LINK_CSLIP) {
+	p = packet;
+	cslip_decompress(&p, &p_size);
+    } else
+#endif
+	p = packet + 128;
+    if (p_size > 0) {
+	ip_recvpacket(p, p_size);
+	netstats.sliprcvcnt++;
+    }
+}
+
 /*
  * slip_process()
  *  Called when we have new data waiting at the serial port
  */
 void slip_process(void)
 {
-    size_t p_size;
-    unsigned char *p;
     int i, len;
 
+    /* kernel line discipline returns one unescaped frame per read*/
+    if (slip_ldisc) {
+	while ((len = read(devfd, packet + 128, sizeof(packet) - 128)) > 0)
+	    slip_recvframe(len);
+	return;
+    }
+
     len = read(devfd, sbuf, SERIAL_BUFFER_SIZE);
     if (len <= 0)
 	return;
@@ -209,18 +237,7 @@ void slip_process(void)
 			if (packpos == 128)
 			    break;
 
-			p_size = packpos - 128;
-#if CSLIP
-			if (linkprotocol == LINK_CSLIP) {
-			    p = packet;
-		            cslip_decompress(&p, &p_size);
-			} else
-#endif
-			    p = packet + 128;
-		        if (p_size > 0) {
-			    ip_recvpacket(p, p_size);
-			    netstats.sliprcvcnt++;
-			}
+			slip_recvframe(packpos - 128);
 
 			/* Reset */
 			packpos = 128;
@@ -273,6 +290,12 @@ void slip_send(unsigned char *packet, int len)
 #endif
     debug_cslip("slip: send %d\n", len);
 
+    if (slip_ldisc) {
+	write(devfd, p, len);	/* kernel escapes and frames*/
+	netstats.slipsndcnt++;
+	return;
+    }
+
     *q++ = END;
     while (len--) {
 	switch (*p) {
@@ -289,8 +312,10 @@ void slip_send(unsigned char *packet, int len)
 	    break;
 	}
 	p++;
-	if (q - buf >= sizeof(buf) - 2)
+	if (q - buf >= sizeof(buf) - 2) {
 	    write(devfd, buf, q - buf);
+	    q = buf;
+	}
     }
     *q++ = END;
     write(devfd, buf, q - buf);
@@ -201,6 +201,7 @@ static void tcp_listen(struct iptcp_s *iptcp, struct tcpcb_s *lcb)
 
     cb->remaddr = iptcp->iph->saddr; /* sender's ip address*/
     cb->remport = ntohs(h->sport);   /* sender's port*/
+    tcpcb_rehash(cb);
     cb->irs = cb->seg_seq;           /* sender's sequence number*/
     cb->rcv_nxt = cb->irs + 1;       /* ktcp's acknum */
     cb->rcv_wnd = ntohs(h->window);
@@ -242,6 +243,7 @@ static void tcp_established(struct iptcp_s *iptcp, struct tcpcb_s *cb)
 	    in_ntoa(cb->remaddr), ntohs(h->sport), ntohs(h->dport));
 	rmv_all_retrans_cb(cb);
 
+	tcpdev_cancel_read(cb, 0);	/* EOF to waiting read*/
 	if (cb->state == TS_CLOSE_WAIT) {
 	    cbs_in_user_timeout--;
 	    ENTER_TIME_WAIT(cb);
@@ -289,6 +291,7 @@ static void tcp_established(struct iptcp_s *iptcp, struct tcpcb_s *cb)
 	acknum = ntohl(h->acknum);
 	if (SEQ_LT(cb->send_una, acknum))
 	    cb->send_una = acknum;
+	tcpdev_notify_writable(cb);	/* retry write refused for window*/
     }
 
     if (h->flags & TF_FIN) {
@@ -298,8 +301,10 @@ static void tcp_established(struct iptcp_s *iptcp, struct tcpcb_s *cb)
 	cb->state = TS_CLOSE_WAIT;
 	cb->time_wait_exp = Now;	/* used for debug output only*/
 	debug_tcp("tcp: got FIN with data %d buffer %d\n", datasize, cb->buf_used);
-	if (cb->bytes_to_push <= 0)
+	if (cb->bytes_to_push <= 0) {
+	    tcpdev_cancel_read(cb, 0);	/* EOF to waiting read*/
 	    notify_sock(cb->sock, TDT_CHG_STATE, SS_DISCONNECTING);
+	}
     }
 
     if (datasize == 0 && ((h->flags & TF_ALL) == TF_ACK))
@@ -445,6 +450,73 @@ static void tcp_last_ack(struct iptcp_s *iptcp, struct tcpcb_s *cb)
     }
 }
 
+/* return local control block at the other end of cb, if any */
+static struct tcpcb_s *tcp_loopback_peer(struct tcpcb_s *cb)
+{
+    struct tcpcb_list_s *n;
+
+    if (cb->remaddr != local_ip)
+	return NULL;
+    n = tcpcb_find(cb->localaddr, cb->remport, cb->localport);
+    return n? &n->tcpcb: NULL;
+}
+
+/*
+ * Loopback fast path: copy application data straight into the receive
+ * buffer of the local peer control block, skipping header construction,
+ * checksums, IP routing and retransmit queueing. Sequence numbers are
+ * advanced as if the segment had been sent and acked, so FIN/RST packets
+ * that follow still go through the normal path.
+ * Returns 1 if data delivered, 0 if normal path should be used,
+ * -1 if peer buffer full.
+ */
+int tcp_loopback_write(struct tcpcb_s *cb, unsigned char *data, unsigned int size)
+{
+    struct tcpcb_s *peer;
+
+    if (cb->send_una != cb->send_nxt)
+	return 0;
+    if (!(peer = tcp_loopback_peer(cb)) || peer->rcv_nxt != cb->send_nxt)
+	return 0;
+    if (peer->state != TS_ESTABLISHED && peer->state != TS_FIN_WAIT_1
+				       && peer->state != TS_FIN_WAIT_2)
+	return 0;
+
+    if (size > CB_BUF_SPACE(peer))
+	return -1;
+
+    tcpcb_buf_write(peer, data, size);
+    if (peer->bytes_to_push <= 0)
+	tcpcb_need_push++;
+    peer->bytes_to_push = peer->buf_used;
+    peer->rcv_nxt += size;
+
+    cb->send_nxt += size;
+    cb->send_una = cb->send_nxt;
+    cb->rcv_wnd = CB_BUF_SPACE(peer);
+
+    netstats.tcpsndcnt++;
+    netstats.tcprcvcnt++;
+    return 1;
+}
+
+/* return 1 if data to cb is arriving through the loopback fast path */
+int tcp_loopback_receiving(struct tcpcb_s *cb)
+{
+    struct tcpcb_s *peer = tcp_loopback_peer(cb);
+
+    return peer && peer->send_una == peer->send_nxt && peer->send_nxt == cb->rcv_nxt;
+}
+
+/* application read from cb, wake local peer waiting to write to it */
+void tcp_loopback_read(struct tcpcb_s *cb)
+{
+    struct tcpcb_s *peer = tcp_loopback_peer(cb);
+
+    if (peer)
+	tcpdev_notify_writable(peer);
+}
+
 /* process an incoming TCP packet*/
 void tcp_process(struct iphdr_s *iph)
 {
@@ -484,6 +556,7 @@ void tcp_process(struct iphdr_s *iph)
 	    cbnode->tcpcb.localport = ntohs(tcph->dport);
 	    cbnode->tcpcb.remaddr = iph->saddr;
 	    cbnode->tcpcb.remport = ntohs(tcph->sport);
+	    tcpcb_rehash(&cbnode->tcpcb);
 	    if (tcph->flags & TF_ACK) {
 		cbnode->tcpcb.flags = TF_RST;
 		cbnode->tcpcb.send_nxt = ntohl(tcph->acknum);
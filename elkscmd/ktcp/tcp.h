@@ -16,6 +16,9 @@
  */
 #define TCPDEV_BUFSIZ	(CB_NORMAL_BUFSIZ + sizeof(struct tdb_return_data))
 
+/* max size of batched replies written to /etc/tcpdev, must hold a max read reply*/
+#define TCPDEV_OBUFSIZ	(TCPDEV_INBUFFERSIZE + 512)
+
 /* max tcp buffer size (no ip header)*/
 #define TCP_BUFSIZ	(TCPDEV_BUFSIZ + sizeof(tcphdr_t) + TCP_OPT_MSS_LEN)
 
@@ -124,7 +127,8 @@ struct tcpcb_s {
 	timeq_t	rtt;			/* in 1/16 secs*/
 
 	__u32	time_wait_exp;
-	//__u16	wait_data;
+	__u16	wait_data;		/* size of kernel read waiting for data*/
+	__u16	wait_write;		/* kernel write waiting for send space*/
 
 	short	bytes_to_push;
 
@@ -158,9 +162,19 @@ struct tcpcb_s {
 
 #define TCP_OPT_MSS_LEN		4	/* total MSS option length*/
 
+/* control block lookup hash tables, see tcp_cb.c*/
+#define TCPCB_HASH_CONN		0	/* remaddr/localport/remport*/
+#define TCPCB_HASH_PORT		1	/* localport*/
+#define TCPCB_HASH_SOCK		2	/* kernel socket*/
+#define TCPCB_NHASH		3
+
+#define TCPCB_HASHSIZE		16	/* buckets per table, must be power of two*/
+
 struct	tcpcb_list_s {
 	struct tcpcb_list_s	*prev;
 	struct tcpcb_list_s	*next;
+	struct tcpcb_list_s	*hnext[TCPCB_NHASH];	/* hash chains*/
+	__u8			hbucket[TCPCB_NHASH];	/* bucket currently linked on*/
 	struct tcpcb_s		tcpcb;	/* must be last */
 };
 
@@ -194,6 +208,9 @@ __u16 tcp_chksum(struct iptcp_s *h);
 __u16 tcp_chksumraw(struct tcphdr_s *h, __u32 saddr, __u32 daddr, __u16 len);
 void tcp_print(struct iptcp_s *head, int recv, struct tcpcb_s *cb);
 void tcp_output(struct tcpcb_s *cb);
+int tcp_loopback_write(struct tcpcb_s *cb, unsigned char *data, unsigned int size);
+int tcp_loopback_receiving(struct tcpcb_s *cb);
+void tcp_loopback_read(struct tcpcb_s *cb);
 int tcp_init(void);
 void tcp_process(struct iphdr_s *iph);
 void tcp_connect(struct tcpcb_s *cb);
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 #include "config.h"
 #include "tcp.h"
@@ -21,11 +22,85 @@
 
 static struct tcpcb_list_s	*tcpcbs;
 
+/*
+ * Lookup hash tables, indexed by TCPCB_HASH_*. Every control block is linked
+ * on one chain in each table; tcpcb_rehash must be called whenever a key
+ * field (remaddr, localport, remport or sock) is changed so that per-packet
+ * and per-request lookups don't have to walk the whole tcpcbs list.
+ */
+static struct tcpcb_list_s	*tcpcb_hash[TCPCB_NHASH][TCPCB_HASHSIZE];
+
+/* list node from control block*/
+#define CB_NODE(cb)	((struct tcpcb_list_s *)((char *)(cb) - offsetof(struct tcpcb_list_s, tcpcb)))
+
 int tcpcb_num;		/* for netstat*/
 
+static unsigned int hash_conn(__u32 addr, __u16 lport, __u16 rport)
+{
+    unsigned int h = (unsigned int)addr ^ (unsigned int)(addr >> 16) ^ lport ^ rport;
+
+    return (h ^ (h >> 8)) & (TCPCB_HASHSIZE - 1);
+}
+
+static unsigned int hash_port(__u16 lport)
+{
+    return (lport ^ (lport >> 8)) & (TCPCB_HASHSIZE - 1);
+}
+
+static unsigned int hash_sock(void *sock)
+{
+    unsigned int h = (unsigned int)sock;
+
+    return (h ^ (h >> 5) ^ (h >> 10)) & (TCPCB_HASHSIZE - 1);
+}
+
+static void hash_link(struct tcpcb_list_s *n, int table, unsigned int bucket)
+{
+    n->hbucket[table] = bucket;
+    n->hnext[table] = tcpcb_hash[table][bucket];
+    tcpcb_hash[table][bucket] = n;
+}
+
+static void hash_unlink(struct tcpcb_list_s *n, int table)
+{
+    struct tcpcb_list_s **pp = &tcpcb_hash[table][n->hbucket[table]];
+
+    for (; *pp; pp = &(*pp)->hnext[table])
+	if (*pp == n) {
+	    *pp = n->hnext[table];
+	    return;
+	}
+}
+
+static void hash_insert(struct tcpcb_list_s *n)
+{
+    struct tcpcb_s *cb = &n->tcpcb;
+
+    hash_link(n, TCPCB_HASH_CONN, hash_conn(cb->remaddr, cb->localport, cb->remport));
+    hash_link(n, TCPCB_HASH_PORT, hash_port(cb->localport));
+    hash_link(n, TCPCB_HASH_SOCK, hash_sock(cb->sock));
+}
+
+static void hash_remove(struct tcpcb_list_s *n)
+{
+    hash_unlink(n, TCPCB_HASH_CONN);
+    hash_unlink(n, TCPCB_HASH_PORT);
+    hash_unlink(n, TCPCB_HASH_SOCK);
+}
+
+/* relink control block after a change to its address, ports or socket*/
+void tcpcb_rehash(struct tcpcb_s *cb)
+{
+    struct tcpcb_list_s *n = CB_NODE(cb);
+
+    hash_remove(n);
+    hash_insert(n);
+}
+
 void tcpcb_init(void)
 {
     tcpcbs = NULL;
+    memset(tcpcb_hash, 0, sizeof(tcpcb_hash));
     tcpcb_need_push = 0;
     cbs_in_time_wait = 0;
     cbs_in_user_timeout = 0;
@@ -79,13 +154,12 @@ struct tcpcb_list_s *tcpcb_new(int bufsize)
     n->tcpcb.rtt = TIMEOUT_INITIAL_RTT;
 
     /* Link it to the list */
-    if (tcpcbs) {
-	n->next = tcpcbs;
-	n->prev = NULL;
+    n->prev = NULL;
+    n->next = tcpcbs;
+    if (tcpcbs)
 	tcpcbs->prev = n;
-	tcpcbs = n;
-    } else
-	tcpcbs = n;
+    tcpcbs = n;
+    hash_insert(n);
     tcpcb_num++;	/* for netstat*/
 
     return n;
@@ -99,44 +173,30 @@ struct tcpcb_list_s *tcpcb_clone(struct tcpcb_s *cb, int bufsize)
 	memcpy(&n->tcpcb, cb, sizeof(struct tcpcb_s));
 	n->tcpcb.buf_size = bufsize;
 	n->tcpcb.buf_head = n->tcpcb.buf_tail = n->tcpcb.buf_used = 0;
+	tcpcb_rehash(&n->tcpcb);
     }
     return n;
 }
 
 void tcpcb_remove_cb(struct tcpcb_s *cb)
 {
-    struct tcpcb_list_s *n;
-
-    for (n=tcpcbs; n; n=n->next)
-	if (&n->tcpcb == cb) {
-	    tcpcb_remove(n);
-	    return;
-	}
+    tcpcb_remove(CB_NODE(cb));
 }
 
 void tcpcb_remove(struct tcpcb_list_s *n)
 {
-    struct tcpcb_list_s *next = n->next;
-
     debug_tcp("tcp: REMOVING control block %x\n", n);
     debug_mem("Free CB\n");
     tcpcb_num--;	/* for netstat*/
 
+    tcpdev_cancel_read(&n->tcpcb, -EPIPE);	/* don't leave kernel read waiting*/
+    hash_remove(n);
     if (n->prev)
-	n->prev->next = next;
-    else {
-	/* Head update */
-	n = next;
-	n->prev = NULL;
-
-	rmv_all_retrans(tcpcbs);
-	free(tcpcbs);
-	tcpcbs = n;
-	return;
-    }
-
-    if (next)
-	next->prev = n->prev;
+	n->prev->next = n->next;
+    else
+	tcpcbs = n->next;	/* Head update */
+    if (n->next)
+	n->next->prev = n->prev;
 
     rmv_all_retrans(n);
     free(n);
@@ -146,7 +206,7 @@ struct tcpcb_list_s *tcpcb_check_port(__u16 lport)
 {
     struct tcpcb_list_s *n;
 
-    for (n=tcpcbs; n; n=n->next)
+    for (n=tcpcb_hash[TCPCB_HASH_PORT][hash_port(lport)]; n; n=n->hnext[TCPCB_HASH_PORT])
 	if (n->tcpcb.localport == lport)
 	    return n;
 
@@ -157,12 +217,14 @@ struct tcpcb_list_s *tcpcb_find(__u32 addr, __u16 lport, __u16 rport)
 {
     struct tcpcb_list_s *n;
 
-    for (n=tcpcbs; n; n=n->next)
+    n = tcpcb_hash[TCPCB_HASH_CONN][hash_conn(addr, lport, rport)];
+    for (; n; n=n->hnext[TCPCB_HASH_CONN])
 	if (n->tcpcb.remaddr == addr && n->tcpcb.remport == rport
 				     && n->tcpcb.localport == lport)
 	    return n;
 
-    for (n=tcpcbs; n; n=n->next)
+    /* no connection, try listening socket*/
+    for (n=tcpcb_hash[TCPCB_HASH_PORT][hash_port(lport)]; n; n=n->hnext[TCPCB_HASH_PORT])
 	if (n->tcpcb.remport == 0 && n->tcpcb.localport == lport)
 	    return n;
 
@@ -173,7 +235,7 @@ struct tcpcb_list_s *tcpcb_find_by_sock(void *sock)
 {
     struct tcpcb_list_s *n;
 
-    for (n=tcpcbs; n; n=n->next)
+    for (n=tcpcb_hash[TCPCB_HASH_SOCK][hash_sock(sock)]; n; n=n->hnext[TCPCB_HASH_SOCK])
 	if (n->tcpcb.sock == sock && n->tcpcb.unaccepted == 0)
 	    return n;
 
@@ -184,7 +246,7 @@ struct tcpcb_list_s *tcpcb_find_unaccepted(void *sock)
 {
     struct tcpcb_list_s *n;
 
-    for (n=tcpcbs; n; n=n->next)
+    for (n=tcpcb_hash[TCPCB_HASH_SOCK][hash_sock(sock)]; n; n=n->hnext[TCPCB_HASH_SOCK])
 	if (n->tcpcb.sock == sock && n->tcpcb.unaccepted == 1)
 	    return n;
 
@@ -7,6 +7,7 @@ void tcpcb_init(void);
 struct tcpcb_list_s *tcpcb_clone(struct tcpcb_s *cb, int bufsize);
 void tcpcb_remove(struct tcpcb_list_s *n);
 void tcpcb_remove_cb(struct tcpcb_s *cb);
+void tcpcb_rehash(struct tcpcb_s *cb);
 void tcpcb_buf_read(struct tcpcb_s *cb, unsigned char *data, int len);
 void tcpcb_buf_write(struct tcpcb_s *cb, unsigned char *data, int len);
 void tcpcb_expire_timeouts(void);
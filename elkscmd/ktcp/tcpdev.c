@@ -15,6 +15,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <errno.h>
@@ -25,7 +26,17 @@
 #include "netconf.h"
 
 static __u16	next_port;
-static unsigned char sbuf[TCPDEV_BUFSIZ];
+
+/*
+ * Requests from and replies to the kernel are batched, each message
+ * preceded by its tdb_len_t length. All requests queued by the kernel are
+ * read into tdbuf at once, and replies are collected in obuf until
+ * tcpdev_flush is called at the top of the main loop.
+ */
+static unsigned char tdbuf[TCPDEV_OUTBUFFERSIZE];	/* requests from kernel*/
+static unsigned char *tdmsg;			/* current request in tdbuf*/
+static unsigned char obuf[TCPDEV_OBUFSIZ];	/* replies to kernel*/
+static unsigned int obuf_len;
 
 int tcpdevfd;
 
@@ -37,6 +48,34 @@ int tcpdev_init(char *fdev)
     return fd;
 }
 
+/* write all queued replies to kernel*/
+void tcpdev_flush(void)
+{
+    if (obuf_len) {
+	if (write(tcpdevfd, obuf, obuf_len) != obuf_len)
+	    printf("ktcp: tcpdev write failed\n");
+	obuf_len = 0;
+    }
+}
+
+/* allocate space for a reply to kernel, sent by tcpdev_flush*/
+static void *tcpdev_alloc(unsigned int len)
+{
+    unsigned char *msg;
+
+    if (obuf_len + sizeof(tdb_len_t) + len > sizeof(obuf))
+	tcpdev_flush();
+    *(tdb_len_t *)&obuf[obuf_len] = len;
+    msg = &obuf[obuf_len + sizeof(tdb_len_t)];
+    obuf_len += sizeof(tdb_len_t) + len;
+    return msg;
+}
+
+static void tcpdev_send(void *msg, unsigned int len)
+{
+    memcpy(tcpdev_alloc(len), msg, len);
+}
+
 void notify_sock(void *sock, int type, int value)
 {
     struct tdb_return_data return_data;
@@ -45,15 +84,26 @@ void notify_sock(void *sock, int type, int value)
     return_data.ret_value = value;
     return_data.sock = sock;
     return_data.size = 0;
-    write(tcpdevfd, &return_data, sizeof(return_data));
+    tcpdev_send(&return_data, sizeof(return_data));
 }
 
-/* inform kernel of socket data bytes available*/
+static void tcpdev_return_data(struct tcpcb_s *cb, unsigned int size);
+
+/* inform kernel of socket data bytes available, or complete a waiting read*/
 void notify_data_avail(struct tcpcb_s *cb)
 {
+    unsigned int size;
+
     if (cb->bytes_to_push <= 0)
 	return;
 
+    if (cb->wait_data) {
+	size = cb->wait_data;
+	cb->wait_data = 0;
+	tcpdev_return_data(cb, size);
+	return;
+    }
+
     notify_sock(cb->sock, TDT_AVAIL_DATA, cb->bytes_to_push);
 }
 
@@ -62,10 +112,29 @@ void retval_to_sock(void *sock, int retval)
     notify_sock(sock, TDT_RETURN, retval);
 }
 
+/* return retval to a read waiting for data, if any*/
+void tcpdev_cancel_read(struct tcpcb_s *cb, int retval)
+{
+    if (cb->wait_data) {
+	debug_tcpdev("tcpdev: cancel read sock %p retval %d\n", cb->sock, retval);
+	cb->wait_data = 0;
+	notify_sock(cb->sock, TDT_READ, retval);
+    }
+}
+
+/* wake a kernel write that was refused for lack of send space*/
+void tcpdev_notify_writable(struct tcpcb_s *cb)
+{
+    if (cb->wait_write) {
+	cb->wait_write = 0;
+	notify_sock(cb->sock, TDT_WRITABLE, 0);
+    }
+}
+
 /* called every ktcp cycle when tcpdevfd data is ready*/
 static void tcpdev_bind(void)
 {
-    struct tdb_bind *db = (struct tdb_bind *)sbuf; /* read from sbuf*/
+    struct tdb_bind *db = (struct tdb_bind *)tdmsg; /* read from tdbuf*/
     struct tcpcb_list_s *n;
     int size;
     __u16 port;
@@ -119,19 +188,20 @@ reject:
     n->tcpcb.localaddr = local_ip;
     n->tcpcb.localport = port;
     n->tcpcb.state = TS_CLOSED;
+    tcpcb_rehash(&n->tcpcb);
 
     bind_ret.type = TDT_BIND;
     bind_ret.ret_value = 0;
     bind_ret.sock = db->sock;
     bind_ret.addr_ip = local_ip;
     bind_ret.addr_port = htons(port);
-    write(tcpdevfd, &bind_ret, sizeof(bind_ret));
+    tcpdev_send(&bind_ret, sizeof(bind_ret));
 }
 
 static void tcpdev_accept(void)
 {
     struct tcpcb_list_s *n,*newn;
-    struct tdb_accept *db = (struct tdb_accept *)sbuf; /* read from sbuf*/
+    struct tdb_accept *db = (struct tdb_accept *)tdmsg; /* read from tdbuf*/
     struct tcpcb_s *cb;
     void *  sock = db->sock;
     struct tdb_accept_ret accept_ret;
@@ -160,6 +230,7 @@ static void tcpdev_accept(void)
     cb->unaccepted = 0;
     cb->sock = db->newsock;
     cb->newsock = 0;			/* clear newsock in accepted CB*/
+    tcpcb_rehash(cb);
     n->tcpcb.newsock = 0;		/* clear newsock in listen CB*/
 
     accept_ret.type = TDT_ACCEPT;
@@ -168,7 +239,7 @@ static void tcpdev_accept(void)
     //accept_ret.sock = db->newsock;	/* report back new socket*/
     accept_ret.addr_ip = cb->remaddr;
     accept_ret.addr_port = htons(cb->remport);
-    write(tcpdevfd, &accept_ret, sizeof(accept_ret));
+    tcpdev_send(&accept_ret, sizeof(accept_ret));
 }
 
 void tcpdev_notify_accept(struct tcpcb_s *cb)
@@ -205,13 +276,14 @@ void tcpdev_notify_accept(struct tcpcb_s *cb)
     cb->unaccepted = 0;
     cb->sock = listencb->newsock;
     listencb->newsock = 0;
+    tcpcb_rehash(cb);
 
-    write(tcpdevfd, &accept_ret, sizeof(accept_ret));
+    tcpdev_send(&accept_ret, sizeof(accept_ret));
 }
 
 static void tcpdev_connect(void)
 {
-    struct tdb_connect *db = (struct tdb_connect *)sbuf; /* read from sbuf*/
+    struct tdb_connect *db = (struct tdb_connect *)tdmsg; /* read from tdbuf*/
     struct tcpcb_list_s *n;
     ipaddr_t addr;
 
@@ -227,6 +299,7 @@ static void tcpdev_connect(void)
 	addr = local_ip;
     n->tcpcb.remaddr = addr;
     n->tcpcb.remport = ntohs(db->addr.sin_port);
+    tcpcb_rehash(&n->tcpcb);
 
     if (n->tcpcb.remport == NETCONF_PORT && n->tcpcb.remaddr == 0) {
 	n->tcpcb.state = TS_ESTABLISHED;
@@ -237,7 +310,7 @@ static void tcpdev_connect(void)
 
 static void tcpdev_listen(void)
 {
-    struct tdb_listen *db = (struct tdb_listen *)sbuf; /* read from sbuf*/
+    struct tdb_listen *db = (struct tdb_listen *)tdmsg; /* read from tdbuf*/
     struct tcpcb_list_s *n;
 
     n = tcpcb_find_by_sock(db->sock);
@@ -255,8 +328,7 @@ static void tcpdev_listen(void)
 /* kernel read data from ktcp (network)*/
 static void tcpdev_read(void)
 {
-    struct tdb_read *db = (struct tdb_read *)sbuf; /* read/write from sbuf*/
-    struct tdb_return_data *ret_data;
+    struct tdb_read *db = (struct tdb_read *)tdmsg; /* read from tdbuf*/
     struct tcpcb_list_s *n;
     struct tcpcb_s *cb;
     unsigned int data_avail;
@@ -264,14 +336,15 @@ static void tcpdev_read(void)
 
     n = tcpcb_find_by_sock(sock);
     if (!n || n->tcpcb.state == TS_CLOSED) {
-	printf("ktcp: panic in read\n");
+	debug_tcpdev("tcpdev_read: no connection for sock %p, return -EPIPE\n", sock);
+	notify_sock(sock, TDT_READ, -EPIPE);	/* kernel read waits for a reply*/
 	return;
     }
 
     cb = &n->tcpcb;
     if (cb->state == TS_CLOSING || cb->state == TS_LAST_ACK || cb->state == TS_TIME_WAIT) {
 	printf("tcpdev_read: returning -EPIPE to socket read state %d\n", cb->state);
-	retval_to_sock(sock, -EPIPE);
+	notify_sock(sock, TDT_READ, -EPIPE);
 	return;
     }
 
@@ -281,29 +354,36 @@ static void tcpdev_read(void)
     if (data_avail == 0) {
 	if (cb->state == TS_CLOSE_WAIT) {
 	    printf("tcpdev_read: read on CLOSE_WAIT socket, return -EPIPE\n");
-	    retval_to_sock(sock, -EPIPE);
+	    notify_sock(sock, TDT_READ, -EPIPE);
 	} else if (db->nonblock)
-	    retval_to_sock(sock, -EAGAIN);
-	else {
-	    //cb->wait_data = db->size;	  /* wait_data use removed, no async reads*/
-	    retval_to_sock(sock, -EINTR); /* don't set wait_data, return -EINTR instead*/
-	}
+	    notify_sock(sock, TDT_READ, -EAGAIN);
+	else
+	    cb->wait_data = db->size;	/* reply when data arrives*/
 	return;
     }
 
-    data_avail = db->size < data_avail ? db->size : data_avail;
+    tcpdev_return_data(cb, db->size);
+}
+
+/* send up to size bytes of received data to kernel as read reply*/
+static void tcpdev_return_data(struct tcpcb_s *cb, unsigned int size)
+{
+    struct tdb_return_data *ret_data;
+    unsigned int data_avail = cb->bytes_to_push;
+
+    data_avail = size < data_avail ? size : data_avail;
     cb->bytes_to_push -= data_avail;
     if (cb->bytes_to_push <= 0)
 	tcpcb_need_push--;
 
     //printf("ktcpdev read: %d bytes\n", data_avail);
-    ret_data = (struct tdb_return_data *)sbuf;
-    ret_data->type = TDT_RETURN;
+    ret_data = tcpdev_alloc(sizeof(struct tdb_return_data) + data_avail);
+    ret_data->type = TDT_READ;
     ret_data->ret_value = data_avail;
     ret_data->size = data_avail;
-    ret_data->sock = sock;
+    ret_data->sock = cb->sock;
     tcpcb_buf_read(cb, ret_data->data, data_avail);
-    write(tcpdevfd, sbuf, sizeof(struct tdb_return_data) + data_avail);
+    tcp_loopback_read(cb);		/* local writer may have room now*/
 
     /* if remote closed and more data, update data avail then indicate disconnecting*/
     if (cb->state == TS_CLOSE_WAIT) {
@@ -320,7 +400,7 @@ static void tcpdev_read(void)
 
     /* send ACK to restart server should window have been full (unless it's netstat)*/
     if (cb->remport != NETCONF_PORT || cb->remaddr != 0)
-	if (cb->remport != local_ip) {	/* no ack to localhost either*/
+	if (!tcp_loopback_receiving(cb)) {	/* fast path sender needs no ack*/
 	    debug_window("tcp: extra ACK seq %ld, app read %d bytes\n",
 		cb->rcv_nxt - cb->irs, data_avail);
 	    tcp_send_ack(cb);
@@ -330,17 +410,12 @@ static void tcpdev_read(void)
 /* kernel write data to ktcp (network)*/
 static void tcpdev_write(void)
 {
-    struct tdb_write *db = (struct tdb_write *)sbuf; /* read from sbuf*/
+    struct tdb_write *db = (struct tdb_write *)tdmsg; /* read from tdbuf*/
     struct tcpcb_list_s *n;
     struct tcpcb_s *cb;
     void *  sock = db->sock;
     unsigned int size, maxwindow;
 
-    sock = db->sock;
-    /*
-     * Must save db->size as sbuf invalid after call to tcp_output,
-     * as when localhost notify_data_avail call uses same sbuf.
-     */
     size = db->size;
 
     /* This is a bit ugly but I'm to lazy right now */
@@ -375,6 +450,17 @@ static void tcpdev_write(void)
 	return;
     }
 
+    /* local connection, move data directly to peer*/
+    switch (tcp_loopback_write(cb, db->data, size)) {
+    case 1:
+	retval_to_sock(sock, size);
+	return;
+    case -1:
+	cb->wait_write = 1;			/* notify when peer reads*/
+	retval_to_sock(sock, -ERESTARTSYS);	/* kernel waits for TDT_WRITABLE*/
+	return;
+    }
+
     /* Delay sending if outstanding send window too large. FIXME could hang if no ACKs rcvd*/
     maxwindow = cb->rcv_wnd;
     if (maxwindow > TCP_SEND_WINDOW_MAX)	/* limit retrans memory usage*/
@@ -382,7 +468,8 @@ static void tcpdev_write(void)
     if (cb->send_nxt - cb->send_una + size > maxwindow) {
 	debug_tcp("tcp limit: seq %lu size %d maxwnd %u unack %lu rcvwnd %u\n",
 	    cb->send_nxt - cb->iss, size, maxwindow, cb->send_nxt - cb->send_una, cb->rcv_wnd);
-	retval_to_sock(sock, -ERESTARTSYS);	/* kernel will retry 100ms later*/
+	cb->wait_write = 1;			/* notify when ACK received*/
+	retval_to_sock(sock, -ERESTARTSYS);	/* kernel waits for TDT_WRITABLE*/
 	return;
     }
 
@@ -398,9 +485,23 @@ static void tcpdev_write(void)
     retval_to_sock(sock, size);
 }
 
+/* kernel read interrupted by signal*/
+static void tcpdev_cancel(void)
+{
+    struct tdb_cancel *db = (struct tdb_cancel *)tdmsg; /* read from tdbuf*/
+    struct tcpcb_list_s *n;
+
+    /* no reply if read already completed*/
+    n = tcpcb_find_by_sock(db->sock);
+    if (n)
+	tcpdev_cancel_read(&n->tcpcb, -EINTR);
+    else
+	notify_sock(db->sock, TDT_READ, -EINTR);	/* connection gone, don't leave read waiting*/
+}
+
 static void tcpdev_release(void)
 {
-    struct tdb_release *db = (struct tdb_release *)sbuf; /* read from sbuf*/
+    struct tdb_release *db = (struct tdb_release *)tdmsg; /* read from tdbuf*/
     struct tcpcb_list_s *n;
     struct tcpcb_s *cb;
     void * sock = db->sock;
@@ -451,13 +552,20 @@ common_close:
 
 void tcpdev_process(void)
 {
-	int len = read(tcpdevfd, sbuf, TCPDEV_BUFSIZ);
-	if (len <= 0)
-		return;
+    int len = read(tcpdevfd, tdbuf, sizeof(tdbuf));
+    unsigned int msglen;
+
+    if (len <= 0)
+	return;
 
-	debug_tcpdev("tcpdev_process read %d bytes\n",len);
+    debug_tcpdev("tcpdev_process read %d bytes\n",len);
 
-	switch (sbuf[0]){
+    for (tdmsg = tdbuf; len > 0; tdmsg += msglen, len -= msglen) {
+	msglen = *(tdb_len_t *)tdmsg;
+	tdmsg += sizeof(tdb_len_t);
+	len -= sizeof(tdb_len_t);
+
+	switch (tdmsg[0]){
 	case TDC_BIND:
 	    debug_tcpdev("tcpdev_bind\n");
 	    tcpdev_bind();
@@ -486,5 +594,10 @@ void tcpdev_process(void)
 	    debug_tcpdev("tcpdev_write\n");
 	    tcpdev_write();
 	    break;
+	case TDC_CANCEL:
+	    debug_tcpdev("tcpdev_cancel\n");
+	    tcpdev_cancel();
+	    break;
 	}
+    }
 }
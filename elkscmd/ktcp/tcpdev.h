@@ -4,10 +4,13 @@
 extern int tcpdevfd;
 
 void tcpdev_process(void);
+void tcpdev_flush(void);
 int tcpdev_init(char *fdev);
 void notify_sock(void *sock, int type, int value);
 void notify_data_avail(struct tcpcb_s *cb);
 void retval_to_sock(void *sock, int r);
 void tcpdev_notify_accept(struct tcpcb_s *cb);
+void tcpdev_cancel_read(struct tcpcb_s *cb, int retval);
+void tcpdev_notify_writable(struct tcpcb_s *cb);
 
 #endif
@@ -51,16 +51,25 @@
 #define uppercase(c)	(((unsigned) ((c) - 'A')) <= ('Z' - 'A'))
 #define downcase(c)	((c) - 'A' + 'a')
 
+#define META		"^$.[()|?+*\\"	/* regular expression metacharacters */
+#define ISMULT(c)	((c) == '*' || (c) == '+' || (c) == '?')
+
 /* Private storage */
 static char *program;		/* program name */
 static char flags[26];		/* invocation flags */
-static regexp *expression;	/* compiled search pattern */
+static regexp *expression;	/* compiled search pattern, NULL if literal */
+static char *literal;		/* string every matching line contains */
+static int litlen;		/* length of literal, 0 if none */
+static unsigned int skip[256];	/* Boyer-Moore-Horspool shift table */
 
 /* External variables. */
 extern int optind;
 extern char *optarg;
 
 /* Internal interfaces */
+static void set_literal();
+static int search();
+static int matches();
 static int match();
 static char *get_line();
 static char *map_nocase();
@@ -109,8 +118,26 @@ char *argv[];
 	}
   }
 
-  if ((expression = regcomp(pattern)) == NULL)
-	error_exit("%s: bad regular expression\n");
+/* Patterns without metacharacters are searched for literally. Otherwise
+ * the literal text the pattern starts with is used to skip lines quickly,
+ * unless there is a '|' that could make it optional.
+ */
+  litlen = strcspn(pattern, META);
+  if (pattern[litlen] == '\0') {
+	set_literal(pattern, litlen);
+  } else {
+	if (*pattern == '^') {
+		literal = pattern + 1;
+		litlen = strcspn(literal, META);
+	} else
+		literal = pattern;
+	if (litlen > 0 && ISMULT(literal[litlen]))
+		litlen--;
+	set_literal(literal, strchr(pattern, '|') ? 0 : litlen);
+	if ((expression = regcomp(pattern)) == NULL)
+		error_exit("%s: bad regular expression\n");
+	expression->regflags |= REG_DFA;	/* no need for match positions */
+  }
 
 /* Process the files appropriately. */
   if (optind == argc) {		/* no file names - find pattern in stdin */
@@ -153,6 +180,63 @@ char *argv[];
 }
 
 
+/* set_literal - set up the Boyer-Moore-Horspool shift table for a literal
+ * string that must appear in matching lines.
+ */
+
+static void set_literal(str, len)
+char *str;
+int len;
+{
+  int i;
+
+  literal = str;
+  litlen = len;
+  for (i = 0; i < 256; i++)
+	skip[i] = len;
+  for (i = 0; i < len - 1; i++)
+	skip[(unsigned char) str[i]] = len - 1 - i;
+}
+
+
+/* search - see if the literal appears in line, by comparing its last
+ * character first and shifting by as much as possible on a mismatch.
+ */
+
+static int search(line)
+char *line;
+{
+  register unsigned char *s = (unsigned char *) line;
+  register unsigned char *lit = (unsigned char *) literal;
+  register int i;
+  int last = litlen - 1;
+  int slen = strlen(line);
+  unsigned char *end;
+
+  if (slen < litlen)
+	return 0;
+  end = s + slen - last;
+  while (s < end) {
+	for (i = last; s[i] == lit[i]; i--)
+		if (i == 0)
+			return 1;
+	s += skip[s[last]];
+  }
+  return 0;
+}
+
+
+/* matches - see if line matches the pattern. */
+
+static int matches(line)
+char *line;
+{
+  if (litlen > 0 && !search(line))
+	return 0;
+  return expression == NULL || regexec(expression, line);
+}
+
+
 /* match - matches the lines of a file with the regular expression.
  * To improve performance when either -s or -l is specified, this
  * function handles those cases specially.
@@ -171,7 +255,7 @@ char *filename;
   if (FLAG('s') || FLAG('l')) {
 	while ((line = get_line(input)) != NULL) {
 		testline = FLAG('i') ? map_nocase(line) : line;
-		if (regexec(expression, testline)) {
+		if (matches(testline)) {
 			status = MATCH;
 			break;
 		}
@@ -186,7 +270,7 @@ char *filename;
   while ((line = get_line(input)) != NULL) {
 	++lineno;
 	testline = FLAG('i') ? map_nocase(line) : line;
-	if (regexec(expression, testline)) {
+	if (matches(testline)) {
 		status = MATCH;
 		if (!FLAG('v')) {
 			if (label != NULL)
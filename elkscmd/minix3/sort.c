@@ -40,6 +40,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <limits.h>
+#include <malloc.h>
 #include "defs.h"
 
 #define OPEN_FILES	(OPEN_MAX-4)	/* Nr of open files per process */
@@ -51,12 +52,17 @@
 					/* Total mem_size */
 #define LINE_SIZE	(1024 >> 1)	/* Max length of a line */
 #define IO_SIZE		(2 * 1024)	/* Size of buffered output */
+#define MAX_LINES	16000		/* Max nr of lines in core */
+#define MAX_LONG	(32 * 1024)	/* Max length of a line sorted in core */
 #define STD_OUT		 1	/* Fd of terminal */
 
 /* Return status of functions */
 #define OK		 0
 #define ERROR		-1
+#define LONG		 1	/* Read_part () filled line without '\n' */
 #define NIL_PTR		((char *) 0)
+#define NIL_FAR		((char __far *) 0)
+#define FP_OFF(fp)	((unsigned) (unsigned long) (fp))
 
 /* Compare return values */
 #define LOWER		-1
@@ -111,9 +117,22 @@ BOOL only_merge = FALSE;
 BOOL uniq = FALSE;
 
 char *mem_top;			/* Mem_top points to lowest pos of memory. */
-char *cur_pos;			/* First free position in mem */
-char **line_table;		/* Pointer to the internal line table */
-BOOL in_core = TRUE;		/* Set if input cannot all be sorted in core */
+
+/* Lines are kept in far memory, with a far table of pointers to them */
+char __far * __far *line_table;	/* Pointer to the internal line table */
+unsigned int nr_lines;		/* Nr of lines in line_table */
+unsigned int max_lines;		/* Nr of entries allocated for line_table */
+BOOL in_core = TRUE;		/* Cleared if input cannot all be sorted in core */
+MERGE input;			/* Input file being read */
+char in_line[LINE_SIZE + 1];	/* Line read from input */
+char __far *long_buf;		/* Input line longer than LINE_SIZE */
+unsigned int long_len, long_max;	/* Used and allocated size of long_buf */
+
+/* Run generation by replacement selection */
+unsigned char cur_run;		/* Run tag of the run being written */
+#define RUN(line)	((unsigned char) ((line)[-1] - cur_run))
+char __far *out_last;		/* Last line written, kept until the next */
+BOOL out_any;			/* Set if out_last is valid */
 
  /* Place where temp_files should be made */
 char temp_files[] = "/tmp/sort.XXXXX.XX";
@@ -138,31 +157,38 @@ _PROTOTYPE(void new_field, (FIELD * field, int *offset, BOOL beg_fl));
 _PROTOTYPE(void adjust_options, (FIELD * field));
 _PROTOTYPE(void error, (BOOL quit, char *message, char *arg));
 _PROTOTYPE(void open_outfile, (void));
-_PROTOTYPE(void get_file, (int fd, off_t size));
-_PROTOTYPE(int last_line, (void));
-_PROTOTYPE(void print_table, (int fd));
+_PROTOTYPE(void get_file, (int fd));
+_PROTOTYPE(int grow_table, (void));
+_PROTOTYPE(int store_line, (char *line));
+_PROTOTYPE(void add_line, (char __far *line));
+_PROTOTYPE(void append_long, (char *line));
+_PROTOTYPE(void spill, (void));
+_PROTOTYPE(void open_run, (void));
+_PROTOTYPE(void put_smallest, (void));
 _PROTOTYPE(char *file_name, (int nr));
-_PROTOTYPE(void mread, (int fd, char *address, int bytes));
 _PROTOTYPE(void mwrite, (int fd, char *address, int bytes));
 _PROTOTYPE(void sort, (void));
-_PROTOTYPE(void sort_table, (int nel));
-_PROTOTYPE(void incr, (int si, int ei));
-_PROTOTYPE(int cmp_fields, (char *el1, char *el2));
-_PROTOTYPE(void build_field, (char *dest, FIELD * field, char *src));
-_PROTOTYPE(char *skip_fields, (unsigned char *str, int nf));
-_PROTOTYPE(int compare, (char *el1, char *el2));
-_PROTOTYPE(int cmp, (unsigned char *el1, unsigned char *el2, FIELD * field));
-_PROTOTYPE(int digits, (unsigned char *str1, unsigned char *str2, BOOL check_sign));
+_PROTOTYPE(BOOL before, (char __far *l1, char __far *l2));
+_PROTOTYPE(void heapify, (void));
+_PROTOTYPE(void sift, (unsigned int i));
+_PROTOTYPE(void insert, (char __far *line));
+_PROTOTYPE(int cmp_fields, (char __far *el1, char __far *el2));
+_PROTOTYPE(void build_field, (char *dest, FIELD * field, char __far *src));
+_PROTOTYPE(char __far *skip_fields, (unsigned char __far *str, int nf));
+_PROTOTYPE(int compare, (char __far *el1, char __far *el2));
+_PROTOTYPE(int cmp, (unsigned char __far *el1, unsigned char __far *el2, FIELD * field));
+_PROTOTYPE(int digits, (unsigned char __far *str1, unsigned char __far *str2, BOOL check_sign));
 _PROTOTYPE(void files_merge, (int file_cnt));
 _PROTOTYPE(void merge, (int start_file, int limit_file));
-_PROTOTYPE(void put_line, (char *line));
+_PROTOTYPE(void put_line, (char __far *line));
 _PROTOTYPE(MERGE * print, (MERGE * merg, int file_cnt));
 _PROTOTYPE(int read_line, (MERGE * merg));
+_PROTOTYPE(int read_part, (MERGE * merg));
 _PROTOTYPE(MERGE * skip_lines, (MERGE * smallest, int file_cnt));
 _PROTOTYPE(void uniq_lines, (MERGE * merg));
 _PROTOTYPE(void check_file, (int fd, char *file));
-_PROTOTYPE(int length, (char *line));
-_PROTOTYPE(void copy, (char *dest, char *src));
+_PROTOTYPE(int length, (char __far *line));
+_PROTOTYPE(void copy, (char *dest, char __far *src));
 _PROTOTYPE(char *msbrk, (int size));
 _PROTOTYPE(void mbrk, (char *address));
 _PROTOTYPE(void catch, (int dummy));
@@ -320,7 +346,7 @@ char *argv[];
   int pid, pow;
 
   argptr = argv;
-  cur_pos = mem_top = msbrk(MEMORY_SIZE);	/* Find lowest mem. location */
+  mem_top = msbrk(MEMORY_SIZE);	/* Find lowest mem. location */
 
   while (arg_count < argc && ((ptr = argv[arg_count])[0] == '-' || *ptr == '+')) {
 	if (*ptr == '-' && *(ptr + 1) == '\0')	/* "-" means stdin */
@@ -382,7 +408,7 @@ char *argv[];
 	if (check)
 		check_file(0, NIL_PTR);
 	else
-		get_file(0, (off_t) 0);
+		get_file(0);
   } else
 	while (arg_count < argc) {	/* Sort or check args */
 		if (strcmp(argv[arg_count], "-") == 0)
@@ -400,7 +426,7 @@ char *argv[];
 		if (check)
 			check_file(fd, argv[arg_count]);
 		else		/* Get_file reads whole file */
-			get_file(fd, st.st_size);
+			get_file(fd);
 		arg_count++;
 	}
 
@@ -408,7 +434,7 @@ char *argv[];
 
   sort();			/* Sort whatever is left */
 
-  if (nr_of_files == 1)		/* Only one file sorted -> don't merge */
+  if (in_core)			/* All sorted in core -> don't merge */
 	exit(0);
 
   files_merge(nr_of_files);
@@ -453,105 +479,159 @@ void open_outfile()
 	error(TRUE, "Cannot creat ", output_file);
 }
 
-/* Get_file reads the whole file of filedescriptor fd. If the file is too big
- * to keep in core, a partial sort is done, and the output is stashed somewhere.
+/* Get_file () reads all lines of the file of filedescriptor fd into far
+ * memory. When core is full, the smallest lines are spilled to runs.
+ * Lines longer than LINE_SIZE are joined in far memory from their parts.
  */
-void get_file(fd, size)
+void get_file(fd)
 int fd;				/* Fd of file to read */
-register off_t size;		/* Size of file */
 {
-  register int i;
-  int rest;			/* Rest in memory */
-  char save_ch;			/* Used in stdin readings */
-
-  rest = MEMORY_SIZE - (cur_pos - mem_top);
-  if (fd == 0) {		/* We're reding stdin */
-	while ((i = read(0, cur_pos, rest)) > 0) {
-		if ((cur_pos - mem_top) + i == MEMORY_SIZE) {
-			in_core = FALSE;
-			i = last_line();	/* End of last line */
-			save_ch = mem_top[i];
-			mem_top[i] = '\0';
-			sort();	/* Sort core */
-			mem_top[i] = save_ch;	/* Restore erased char */
-			/* Restore last (half read) line */
-			for (rest = 0; i + rest != MEMORY_SIZE; rest++)
-				mem_top[rest] = mem_top[i + rest];
-			/* Assign current pos. in memory */
-			cur_pos = &mem_top[rest];
-		} else {	/* Fits, just assign position in mem. */
-			cur_pos = cur_pos + i;
-			*cur_pos = '\0';
-		}
+  register MERGE *merg = &input;
+  int ret;
 
-		/* Calculate rest of mem */
-		rest = MEMORY_SIZE - (cur_pos - mem_top);
+  merg->fd = fd;
+  merg->buffer = mem_top;
+  merg->line = in_line;
+  merg->cnt = merg->read_chars = 0;
+  buf_size = MEMORY_SIZE;
+
+  while ((ret = read_part(merg)) != ERROR) {
+	if (ret == LONG || long_buf != NIL_FAR) {
+		append_long(merg->line);
+		if (ret == LONG) continue;
+		while (nr_lines == max_lines && grow_table() == ERROR)
+			spill();
+		add_line(long_buf + 1);
+		long_buf = NIL_FAR;
+		long_len = long_max = 0;
+		continue;
 	}
+	while (store_line(merg->line) == ERROR)
+		spill();	/* Make room for line */
   }
+}
 
-  /* Reading file. Check size */
-  else if (size > rest) {	/* Won't fit */
-	mread(fd, cur_pos, rest);
-	in_core = FALSE;
-	i = last_line();	/* Get pos. of last line */
-	mem_top[i] = '\0';	/* Truncate */
-	(void) lseek(fd, (off_t) (i - MEMORY_SIZE), SEEK_CUR);	/* Do this next time */
-	size = size - rest - i + MEMORY_SIZE;	/* Calculate rest */
-	cur_pos = mem_top;	/* Reset mem */
-	sort();			/* Sort core */
-	get_file(fd, size);	/* Get rest of file */
-  } else {			/* Fits. Just read in */
-	rest = size;
-	mread(fd, cur_pos, rest);
-	cur_pos = cur_pos + rest;	/* Reassign cur_pos */
-	*cur_pos = '\0';
-	(void) close(fd);	/* File completed */
+/* Append_long () adds the next part of a long input line to long_buf. */
+void append_long(line)
+char *line;
+{
+  register char __far *ptr;
+  unsigned int len = strlen(line);
+
+  if (long_buf == NIL_FAR) long_len = 1;	/* Room for run tag */
+  while (long_len + len > long_max) {
+	if (long_max + LINE_SIZE > MAX_LONG)
+		error(TRUE, "Line too long", NIL_PTR);
+	if ((ptr = frealloc(long_buf, long_max + LINE_SIZE)) == NIL_FAR)
+		spill();	/* Make room for line */
+	else {
+		long_buf = ptr;
+		long_max += LINE_SIZE;
+	}
   }
+  fmemcpy(long_buf + long_len, line, len);
+  long_len += len;
 }
 
-/* Last_line () find the last line in core and retuns the offset from the top
- * of the memory.
+/* Grow_table () doubles the far line table, up to MAX_LINES entries. */
+int grow_table()
+{
+  char __far * __far *table;
+  unsigned int n;
+
+  n = max_lines ? max_lines << 1 : (MAX_LINES >> 4);
+  if (n > MAX_LINES) n = MAX_LINES;
+  if (n == max_lines) return ERROR;
+  table = frealloc(line_table, n * sizeof(char __far *));
+  if (table == (char __far * __far *) 0) return ERROR;
+  line_table = table;
+  max_lines = n;
+  return OK;
+}
+
+/* Store_line () copies line into far memory and adds it to the line table.
+ * ERROR is returned if there is no room.
  */
-int last_line()
+int store_line(line)
+char *line;
 {
-  register int i;
+  register char __far *ptr;
+  int len = length(line);
 
-  for (i = MEMORY_SIZE - 2; i > 0; i--)
-	if (mem_top[i] == '\n') break;
-  return i + 1;
+  if (nr_lines == max_lines && grow_table() == ERROR) return ERROR;
+  if ((ptr = fmalloc(len + 1)) == NIL_FAR) return ERROR;
+  fmemcpy(ptr + 1, line, len);
+  add_line(ptr + 1);
+  return OK;
 }
 
-/* Print_table prints the line table in the given file_descriptor. If the fd
- * equals ERROR, it opens a temp_file itself.
+/* Add_line () adds a line in far memory to the line table, which must have
+ * room. The byte before each stored line holds the run it belongs to: the
+ * current run, or the next one if it sorts before the line last written to
+ * the current run.
  */
-void print_table(fd)
-int fd;
+void add_line(line)
+register char __far *line;
 {
-  register char **line_ptr;	/* Ptr in line_table */
-  register char *ptr;		/* Ptr to line */
-  int index = 0;		/* Index in output buffer */
+  if (!in_core && out_any && compare(line, out_last) < 0)
+	line[-1] = cur_run + 1;
+  else
+	line[-1] = cur_run;
 
-  if (fd == ERROR) {
-	if ((fd = creat(file_name(nr_of_files), 0644)) < 0)
-		error(TRUE, "Cannot creat ", file_name(nr_of_files));
+  if (in_core)
+	line_table[nr_lines++] = line;
+  else
+	insert(line);
+}
+
+/* Spill () makes room in core by writing the smallest line to the current
+ * run. The first time core fills up, the line table is made into a heap and
+ * the first run is started. Replacement selection makes the runs twice the
+ * size of core on average, and sorted input becomes a single run.
+ */
+void spill()
+{
+  if (nr_lines == 0)
+	error(TRUE, "Not enough memory", NIL_PTR);
+  if (in_core) {
+	in_core = FALSE;
+	heapify();
+	open_run();
   }
-  for (line_ptr = line_table; *line_ptr != NIL_PTR; line_ptr++) {
-	ptr = *line_ptr;
-	/* Skip all same lines if uniq is set */
-	if (uniq && *(line_ptr + 1) != NIL_PTR) {
-		if (compare(ptr, *(line_ptr + 1)) == SAME) continue;
-	}
-	do {			/* Print line in a buffered way */
-		out_buffer[index++] = *ptr;
-		if (index == IO_SIZE) {
-			mwrite(fd, out_buffer, IO_SIZE);
-			index = 0;
-		}
-	} while (*ptr++ != '\n');
+  put_smallest();
+}
+
+/* Open_run () creates the temp file for the next run. */
+void open_run()
+{
+  if ((out_fd = creat(file_name(nr_of_files), 0644)) < 0)
+	error(TRUE, "Cannot creat ", file_name(nr_of_files));
+  nr_of_files++;
+  if (out_any) ffree(out_last - 1);
+  out_any = FALSE;
+}
+
+/* Put_smallest () writes the top of the heap and frees it. If its run tag
+ * says it belongs to the next run, the current run is complete.
+ */
+void put_smallest()
+{
+  register char __far *line = line_table[0];
+
+  if (RUN(line) != 0) {
+	put_line(NIL_FAR);	/* Close current run */
+	cur_run++;
+	open_run();
   }
-  mwrite(fd, out_buffer, index);/* Flush buffer */
-  (void) close(fd);		/* Close file */
-  nr_of_files++;		/* Increment nr_of_files to merge */
+  line_table[0] = line_table[--nr_lines];
+  sift(0);
+  if (!uniq || !out_any || compare(line, out_last) != SAME) {
+	put_line(line);
+	if (out_any) ffree(out_last - 1);
+	out_last = line;	/* Remember last line written */
+	out_any = TRUE;
+  } else
+	ffree(line - 1);
 }
 
 /* File_name () returns the nr argument from the argument list, or a uniq
@@ -569,16 +649,6 @@ register int nr;
   return temp_files;
 }
 
-/* Mread () performs a normal read (), but checks the return value. */
-void mread(fd, address, bytes)
-int fd;
-char *address;
-register int bytes;
-{
-  if (read(fd, address, bytes) < 0 && bytes != 0)
-	error(TRUE, "Read error", NIL_PTR);
-}
-
 /* Mwrite () performs a normal write (), but checks the return value. */
 void mwrite(fd, address, bytes)
 int fd;
@@ -589,77 +659,67 @@ register int bytes;
 	error(TRUE, "Write error", NIL_PTR);
 }
 
-/* Sort () sorts the input in memory starting at mem_top. */
+/* Sort () writes out whatever is left in core. If everything fitted, it is
+ * sorted and written to the output file, else it finishes the last runs.
+ */
 void sort()
 {
-  register char *ptr = mem_top;
-  register int count = 0;
-
-/* Count number of lines in memory */
-  while (*ptr) {
-	if (*ptr++ == '\n') count++;
-  }
-
-/* Set up the line table */
-  line_table = (char **) msbrk(count * sizeof(char *) + sizeof(char *));
-
-  count = 1;
-  ptr = line_table[0] = mem_top;
-  while (*ptr) {
-	if (*ptr++ == '\n') line_table[count++] = ptr;
-  }
-
-  line_table[count - 1] = NIL_PTR;
-
-/* Sort the line table */
-  sort_table(count - 1);
-
-/* Stash output somewhere */
   if (in_core) {
+	heapify();
 	open_outfile();
-	print_table(out_fd);
-  } else
-	print_table(ERROR);
+  }
+  while (nr_lines > 0) put_smallest();
+  put_line(NIL_FAR);		/* Flush and close */
+}
+
+/* Before () returns TRUE if line l1 must be written before line l2. */
+BOOL before(l1, l2)
+register char __far *l1, *l2;
+{
+  int r1 = RUN(l1), r2 = RUN(l2);
 
-/* Free line table */
-  mbrk((char *) line_table);
+  if (r1 != r2) return r1 < r2;
+  return compare(l1, l2) < 0;
 }
 
-/* Sort_table () sorts the line table consisting of nel elements. */
-void sort_table(nel)
-register int nel;
+/* Heapify () turns the line table into a heap with the smallest line on top. */
+void heapify()
 {
-  char *tmp;
-  register int i;
+  register unsigned int i;
 
-  /* Make heap */
-  for (i = (nel >> 1); i >= 1; i--) incr(i, nel);
+  for (i = nr_lines >> 1; i-- > 0;) sift(i);
+}
 
-  /* Sort from heap */
-  for (i = nel; i > 1; i--) {
-	tmp = line_table[0];
-	line_table[0] = line_table[i - 1];
-	line_table[i - 1] = tmp;
-	incr(1, i - 1);
+/* Sift () moves the line at index i of the heap down to its place. */
+void sift(i)
+register unsigned int i;
+{
+  register unsigned int child;
+  char __far *tmp = line_table[i];
+
+  while ((child = (i << 1) + 1) < nr_lines) {
+	if (child + 1 < nr_lines &&
+	    before(line_table[child + 1], line_table[child]))
+		child++;
+	if (!before(line_table[child], tmp)) break;
+	line_table[i] = line_table[child];
+	i = child;
   }
+  line_table[i] = tmp;
 }
 
-/* Incr () increments the heap. */
-void incr(si, ei)
-register int si, ei;
+/* Insert () adds line to the heap. */
+void insert(line)
+char __far *line;
 {
-  char *tmp;
+  register unsigned int i = nr_lines++;
+  register unsigned int parent;
 
-  while (si <= (ei >> 1)) {
-	si <<= 1;
-	if (si + 1 <= ei && compare(line_table[si - 1], line_table[si]) <= 0)
-		si++;
-	if (compare(line_table[(si >> 1) - 1], line_table[si - 1]) >= 0)
-		return;
-	tmp = line_table[(si >> 1) - 1];
-	line_table[(si >> 1) - 1] = line_table[si - 1];
-	line_table[si - 1] = tmp;
+  while (i > 0 && before(line, line_table[parent = (i - 1) >> 1])) {
+	line_table[i] = line_table[parent];
+	i = parent;
   }
+  line_table[i] = line;
 }
 
 /* Cmp_fields builds new lines out of the lines pointed to by el1 and el2 and
@@ -667,7 +727,7 @@ register int si, ei;
  * with the field describing the arguments.
  */
 int cmp_fields(el1, el2)
-register char *el1, *el2;
+register char __far *el1, *el2;
 {
   int i, ret;
   char line1[LINE_SIZE], line2[LINE_SIZE];
@@ -693,33 +753,37 @@ register char *el1, *el2;
 void build_field(dest, field, src)
 char *dest;			/* Holds result */
 register FIELD *field;		/* Field description */
-register char *src;		/* Source line */
+register char __far *src;	/* Source line */
 {
-  char *begin = src;		/* Remember start location */
-  char *last;			/* Pointer to end location */
+  char __far *begin = src;	/* Remember start location */
+  char __far *last;		/* Pointer to end location */
   int i;
+  unsigned int len;		/* Length of part copied */
 
 /* Skip begin fields */
-  src = skip_fields((unsigned char *)src, field->beg_field);
+  src = skip_fields((unsigned char __far *)src, field->beg_field);
 
 /* Skip begin positions */
   for (i = 0; i < field->beg_pos && *src != '\n'; i++) src++;
 
-/* Copy whatever is left */
-  copy(dest, src);
+/* Copy whatever is left, keys are compared up to LINE_SIZE */
+  for (len = 0; len < LINE_SIZE - 1 && (dest[len] = src[len]) != '\n'; len++)
+	;
+  dest[len] = '\n';
 
 /* If end field is assigned truncate (perhaps) the part copied */
   if (field->end_field != ERROR) {	/* Find last field */
-	last = skip_fields((unsigned char *)begin, field->end_field);
+	last = skip_fields((unsigned char __far *)begin, field->end_field);
 /* Skip positions as given by end fields description */
 	for (i = 0; i < field->end_pos && *last != '\n'; i++) last++;
-	dest[last - src] = '\n';/* Truncate line */
+	if (FP_OFF(last) - FP_OFF(src) < len)
+		dest[FP_OFF(last) - FP_OFF(src)] = '\n';	/* Truncate line */
   }
 }
 
 /* Skip_fields () skips nf fields of the line pointed to by str. */
-char *skip_fields(str, nf)
-register unsigned char *str;
+char __far *skip_fields(str, nf)
+register unsigned char __far *str;
 int nf;
 {
   while (nf-- > 0) {
@@ -731,7 +795,7 @@ int nf;
 		if (*str == separator) str++;
 	}
   }
-  return (char *)str;			/* Return pointer to indicated field */
+  return (char __far *)str;	/* Return pointer to indicated field */
 }
 
 /* Compare is called by all sorting routines. It checks if fields assignments
@@ -739,13 +803,14 @@ int nf;
  * reversed the return value if the (global) reverse flag is set.
  */
 int compare(el1, el2)
-register char *el1, *el2;
+register char __far *el1, *el2;
 {
   int ret;
 
   if (field_cnt > GLOBAL) return cmp_fields(el1, el2);
 
-  ret = cmp((unsigned char *) el1, (unsigned char *) el2, &fields[GLOBAL]);
+  ret = cmp((unsigned char __far *) el1, (unsigned char __far *) el2,
+	    &fields[GLOBAL]);
   return(fields[GLOBAL].reverse) ? -ret : ret;
 }
 
@@ -753,7 +818,7 @@ register char *el1, *el2;
  * description given in the field pointer.
  */
 int cmp(el1, el2, field)
-register unsigned char *el1, *el2;
+register unsigned char __far *el1, *el2;
 FIELD *field;
 {
   int c1, c2;
@@ -819,7 +884,7 @@ FIELD *field;
  * by an optional decimal point.
  */
 int digits(str1, str2, check_sign)
-register unsigned char *str1, *str2;
+register unsigned char __far *str1, *str2;
 BOOL check_sign;		/* True if sign must be checked */
 {
   BOOL negative = FALSE;	/* True if negative numbers */
@@ -975,18 +1040,18 @@ int start_file, limit_file;
   else				/* Print rest of file */
 	while (print(smallest, file_cnt) != NIL_MERGE);
 
-  put_line(NIL_PTR);		/* Flush output buffer */
+  put_line(NIL_FAR);		/* Flush output buffer */
 }
 
 /* Put_line () prints the line into the out_fd filedescriptor. If line equals
- * NIL_PTR, the out_fd is flushed and closed.
+ * NIL_FAR, the out_fd is flushed and closed.
  */
 void put_line(line)
-register char *line;
+register char __far *line;
 {
   static int index = 0;		/* Index in out_buffer */
 
-  if (line == NIL_PTR) {	/* Flush and close */
+  if (line == NIL_FAR) {	/* Flush and close */
 	mwrite(out_fd, out_buffer, index);
 	index = 0;
 	(void) close(out_fd);
@@ -1028,12 +1093,24 @@ int file_cnt;			/* Nr of files that are being merged */
 }
 
 /* Read_line () reads a line from the fd from the merg struct. If the read
- * failed, disabled is incremented and the file is closed. Readings are
- * done in buf_size bytes.
- * Lines longer than LINE_SIZE are silently truncated.
+ * failed, disabled is incremented and the file is closed.
+ * Lines longer than LINE_SIZE are an error, rather than being split.
  */
 int read_line(merg)
 register MERGE *merg;
+{
+  int ret = read_part(merg);
+
+  if (ret == LONG) error(TRUE, "Line too long", NIL_PTR);
+  return ret;
+}
+
+/* Read_part () reads a line, or as much of it as fits in LINE_SIZE, from
+ * the fd from the merg struct. LONG is returned with the part read and no
+ * '\n' if the line continues. Readings are done in buf_size bytes.
+ */
+int read_part(merg)
+register MERGE *merg;
 {
   register char *ptr = merg->line - 1;	/* Ptr buf that will hold line */
 
@@ -1042,6 +1119,11 @@ register MERGE *merg;
 	if (merg->cnt == merg->read_chars) {	/* Read new buffer */
 		if ((merg->read_chars =
 		     read(merg->fd, merg->buffer, buf_size)) <= 0) {
+			if (ptr != merg->line) {	/* Last line has no '\n' */
+				merg->cnt = merg->read_chars = 0;
+				*ptr = '\n';
+				break;
+			}
 			(void) close(merg->fd);	/* OOPS */
 			merg->fd = ERROR;
 			disabled++;
@@ -1050,8 +1132,11 @@ register MERGE *merg;
 		merg->cnt = 0;
 	}
 	*ptr = merg->buffer[merg->cnt++];	/* Assign next char of line */
-	if (ptr - merg->line == LINE_SIZE - 1)
-		*ptr = '\n';	/* Truncate very long lines */
+	if (ptr - merg->line == LINE_SIZE - 1 && *ptr != '\n' && *ptr != '\0') {
+		merg->cnt--;	/* Leave char for the next part */
+		*ptr = '\0';
+		return LONG;
+	}
   } while (*ptr != '\n' && *ptr != '\0');
 
   if (*ptr == '\0')		/* Add '\n' to last line */
@@ -1149,7 +1234,7 @@ char *file;
 
 /* Length () returns the length of the argument line including the linefeed. */
 int length(line)
-register char *line;
+register char __far *line;
 {
   register int i = 1;		/* Add linefeed */
 
@@ -1159,7 +1244,8 @@ register char *line;
 
 /* Copy () copies the src line into the dest line including linefeed. */
 void copy(dest, src)
-register char *dest, *src;
+register char *dest;
+register char __far *src;
 {
   while ((*dest++ = *src++) != '\n');
 }
@@ -76,6 +76,7 @@ static char GlobalAttr, TmpAttr, GlobalCharset, TmpCharset;
 static char *OldImage, *OldAttr, *OldFont;
 static int last_x, last_y;
 static struct win *curr;
+static struct win *shown;       /* window whose image is on the terminal */
 static int display = 1;
 static int StrCost;
 static int UPcost, DOcost, LEcost, NDcost, CRcost, IMcost, EIcost;
@@ -103,6 +104,8 @@ InitTerm(void)
 {
     char *s;
 
+    /* output is flushed before each select, so buffer whole updates */
+    setvbuf(stdout, NULL, _IOFBF, BUFSIZ);
     if ((s = getenv("TERM")) == 0)
         Msg(0, "No TERM in environment.");
     if (tgetent(tbuf, s) != 1)
@@ -223,6 +226,7 @@ InitTerm(void)
 int
 FinitTerm(void)
 {
+    shown = 0;
     PutStr(TE);
     PutStr(IS);
     return 0;
@@ -350,23 +354,47 @@ MakeString(char *cap, char *buf, char *s)
     return 0;
 }
 
+/*
+ * Switch the terminal to window wp.  If another window is still shown,
+ * only the cells that differ between the two images are redrawn,
+ * otherwise (or when wp is already shown) the screen is cleared and
+ * redrawn in full.
+ */
 int
 Activate(struct win *wp)
 {
-    RemoveStatus(wp);
+    struct win *old = shown;
+    int full = !old || old == wp;
+    int homed = 0;
+
+    RemoveStatus(old ? old : wp);
     curr = wp;
     display = 1;
     NewRendition(GlobalAttr, curr->LocalAttr);
     GlobalAttr = curr->LocalAttr;
     NewCharset(GlobalCharset, curr->charsets[curr->LocalCharset]);
     GlobalCharset = curr->charsets[curr->LocalCharset];
-    if (CS)
+    if (CS && (full || old->top != curr->top || old->bot != curr->bot)) {
         PutStr(tgoto(CS, curr->bot, curr->top));
-    Redisplay();
+        homed = 1;              /* cursor position now unknown */
+    }
+    if (full)
+        Redisplay();
+    else
+        UpdateDisplay(old, homed);
+    shown = wp;
     KeypadMode(curr->keypad);
     return 0;
 }
 
+/* Window wp is going away, its image can no longer be diffed against */
+void
+ForgetWindow(struct win *wp)
+{
+    if (wp == shown)
+        shown = 0;
+}
+
 int
 ResetScreen(struct win *p)
 {
@@ -1837,6 +1865,42 @@ Redisplay(void)
     return 0;
 }
 
+/* Redraw only the lines and cells of curr that differ from the shown window old */
+static int
+UpdateDisplay(struct win *old, int homed)
+{
+    int i;
+
+    /* the last cell can't be written without scrolling with auto margins */
+    if (AM && (old->image[rows - 1][cols - 1] != curr->image[rows - 1][cols - 1]
+            || old->attr[rows - 1][cols - 1] != curr->attr[rows - 1][cols - 1]
+            || old->font[rows - 1][cols - 1] != curr->font[rows - 1][cols - 1]))
+        return Redisplay();
+    TmpAttr = GlobalAttr;
+    TmpCharset = GlobalCharset;
+    InsertMode(0);
+    if (homed)
+        last_x = last_y = -1;
+    else {
+        last_x = old->x;
+        last_y = old->y;
+    }
+    for (i = 0; i < rows; ++i) {
+        if (!memcmp(old->image[i], curr->image[i], cols)
+            && !memcmp(old->attr[i], curr->attr[i], cols)
+            && !memcmp(old->font[i], curr->font[i], cols))
+            continue;
+        DisplayLine(old->image[i], old->attr[i], old->font[i], curr->image[i],
+                    curr->attr[i], curr->font[i], i, 0, cols - 1);
+    }
+    if (curr->insert)
+        InsertMode(1);
+    NewRendition(TmpAttr, GlobalAttr);
+    NewCharset(TmpCharset, GlobalCharset);
+    Goto(last_y, last_x, curr->y, curr->x);
+    return 0;
+}
+
 static void
 DisplayLine(char *os, char *oa, char *of, char *s, char *as, char *fs, int y, int from, int to)
 {
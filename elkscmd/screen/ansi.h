@@ -63,6 +63,7 @@ static int SaveAttr(int newattr);
 static int RestoreAttr(int oldattr);
 static int FillWithEs(void);
 static int Redisplay(void);
+static int UpdateDisplay(struct win *old, int homed);
 static int MakeBlankLine(char *p, int n);
 
 int Activate(struct win *wp);
@@ -71,3 +72,4 @@ void WriteString(struct win *wp, char *buf, int len);
 void DoESC(int c, int intermediate);
 int MakeStatus(char *msg, struct win *wp);
 void RemoveStatus(struct win *p);
+void ForgetWindow(struct win *wp);
@@ -117,6 +117,7 @@ int InitTerm(void);
 int FinitTerm(void);
 void WriteString(struct win *wp, char *buf, int len);
 int Activate(struct win *wp);
+void ForgetWindow(struct win *wp);
 void DoESC(int c, int intermediate);
 int ResetScreen(struct win *p);
 void RemoveStatus(struct win *p);
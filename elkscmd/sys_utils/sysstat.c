@@ -0,0 +1,165 @@
+/*
+ * sysstat - show per system call counts and latencies
+ *
+ * Usage (kernel built with CONFIG_SYSSTAT):
+ *  sysstat start | stop | free
+ *  sysstat [-c | -m] [-n count]            show statistics
+ *  sysstat [-c | -m] [-n count] command    count system calls during command
+ *
+ * Calls are sorted by total time, or by count with -c or max time with -m.
+ * Times include time spent sleeping in the call.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/sysstat.h>
+#include "strace.h"     /* system call names from kernel */
+
+#define PTICKS_PER_MS   1193    /* precision timer pticks */
+
+static struct sysstat stats[SYSSTAT_CALLS];
+static int order[SYSSTAT_CALLS];
+static int sortkey = 't';
+
+static const char *callname(int n)
+{
+    static char buf[8];
+    const char *s = NULL;
+
+    if (n < sizeof(elks_table1) / sizeof(struct sc_info))
+        s = elks_table1[n].s_name;
+    else if (n >= START_TABLE2 &&
+             n < START_TABLE2 + sizeof(elks_table2) / sizeof(struct sc_info))
+        s = elks_table2[n - START_TABLE2].s_name;
+    if (!s) {
+        sprintf(buf, "#%d", n);
+        s = buf;
+    }
+    return s;
+}
+
+/* convert pticks to usecs without overflow */
+static unsigned long usecs(unsigned long pticks)
+{
+    return pticks / PTICKS_PER_MS * 1000 + (pticks % PTICKS_PER_MS) * 1000 / PTICKS_PER_MS;
+}
+
+static unsigned long key(int n)
+{
+    switch (sortkey) {
+    case 'c':   return stats[n].count;
+    case 'm':   return stats[n].max;
+    }
+    return stats[n].total;
+}
+
+static int cmpkey(const void *a, const void *b)
+{
+    unsigned long ka = key(*(const int *)a);
+    unsigned long kb = key(*(const int *)b);
+
+    if (ka == kb)
+        return 0;
+    return ka < kb? 1: -1;
+}
+
+static int report(int lines)
+{
+    int i, n, nused = 0;
+    unsigned long calls = 0, total = 0;
+
+    n = sysstat(SYSSTAT_READ, (char *)stats, sizeof(stats));
+    if (n < 0) {
+        perror("sysstat");
+        return 1;
+    }
+    if (n == 0) {
+        fprintf(stderr, "sysstat: not started\n");
+        return 1;
+    }
+    for (i = 0; i < n / sizeof(struct sysstat); i++) {
+        if (stats[i].count) {
+            order[nused++] = i;
+            calls += stats[i].count;
+            total += stats[i].total;
+        }
+    }
+    qsort(order, nused, sizeof(int), cmpkey);
+    printf("%-12s %8s %10s %8s %8s\n", "syscall", "calls", "total ms", "avg us", "max us");
+    for (i = 0; i < nused && i < lines; i++) {
+        struct sysstat *s = &stats[order[i]];
+        printf("%-12s %8lu %10lu %8lu %8lu\n", callname(order[i]), s->count,
+            usecs(s->total) / 1000, usecs(s->total / s->count), usecs(s->max));
+    }
+    printf("%-12s %8lu %10lu\n", "total", calls, usecs(total) / 1000);
+    return 0;
+}
+
+static int control(int op)
+{
+    if (sysstat(op, NULL, 0) < 0) {
+        perror("sysstat");
+        return 1;
+    }
+    return 0;
+}
+
+static int run(char **av)
+{
+    int pid, status;
+
+    if (control(SYSSTAT_START))
+        return 1;
+    if ((pid = fork()) < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        execvp(av[0], av);
+        perror(av[0]);
+        _exit(127);
+    }
+    while (waitpid(pid, &status, 0) < 0)
+        continue;
+    return control(SYSSTAT_STOP);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: sysstat start | stop | free\n"
+            "       sysstat [-c | -m] [-n count] [command [args]]\n");
+    exit(1);
+}
+
+int main(int ac, char **av)
+{
+    int lines = 30;
+    int ch;
+
+    if (ac == 2) {
+        if (!strcmp(av[1], "start"))
+            return control(SYSSTAT_START);
+        if (!strcmp(av[1], "stop"))
+            return control(SYSSTAT_STOP);
+        if (!strcmp(av[1], "free"))
+            return control(SYSSTAT_FREE);
+    }
+    while ((ch = getopt(ac, av, "cmn:")) != -1) {
+        switch (ch) {
+        case 'c':
+        case 'm':
+            sortkey = ch;
+            break;
+        case 'n':
+            lines = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind < ac && run(&av[optind]))
+        return 1;
+    return report(lines);
+}
@@ -0,0 +1,232 @@
+/*
+ * tcpbench - TCP/IP stack benchmark
+ *
+ * Measures connection setup rate, small message round trip rate and bulk
+ * throughput through the kernel socket layer and ktcp.
+ * Run with -s as server (in background) and then as client, e.g.
+ *
+ *	tcpbench -s &
+ *	tcpbench 127.0.0.1
+ *
+ * or between two machines to include the network driver path.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define DEF_PORT	5001
+#define MSGSIZE		16	/* round trip message size */
+#define BUFSIZE		1024	/* bulk transfer write size */
+
+/* first byte sent by client selects test */
+#define CMD_CONNECT	'c'
+#define CMD_ECHO	'e'
+#define CMD_DISCARD	'd'
+
+static char buf[BUFSIZE];
+
+static unsigned long mstime(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
+
+static void report(char *name, long count, char *unit, unsigned long ms)
+{
+	if (ms == 0)
+		ms = 1;
+	printf("%-10s %6ld %-6s %6lu ms %8lu %s/s\n", name, count, unit, ms,
+		count * 1000L / ms, unit);
+}
+
+static int readn(int fd, char *p, int n)
+{
+	int ret, count = 0;
+
+	while (count < n) {
+		ret = read(fd, p + count, n - count);
+		if (ret <= 0)
+			return ret;
+		count += ret;
+	}
+	return count;
+}
+
+static void serve(int fd)
+{
+	char cmd;
+	int n;
+
+	if (read(fd, &cmd, 1) != 1)
+		return;
+	switch (cmd) {
+	case CMD_ECHO:
+		while (readn(fd, buf, MSGSIZE) == MSGSIZE)
+			if (write(fd, buf, MSGSIZE) != MSGSIZE)
+				break;
+		break;
+	case CMD_DISCARD:
+		while ((n = read(fd, buf, sizeof(buf))) > 0)
+			continue;
+		break;
+	}
+}
+
+static int server(int port)
+{
+	struct sockaddr_in addr;
+	int fd, cl;
+	int on = 1;
+
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		perror("socket");
+		return 1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		perror("bind");
+		return 1;
+	}
+	if (listen(fd, 5) < 0) {
+		perror("listen");
+		return 1;
+	}
+	for (;;) {
+		if ((cl = accept(fd, NULL, NULL)) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			return 1;
+		}
+		serve(cl);
+		close(cl);
+	}
+}
+
+static int client_connect(struct sockaddr_in *addr, char cmd)
+{
+	int fd;
+
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		perror("socket");
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)addr, sizeof(*addr)) < 0) {
+		perror("connect");
+		close(fd);
+		return -1;
+	}
+	if (write(fd, &cmd, 1) != 1) {
+		perror("write");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int client(struct sockaddr_in *addr, int count, int kbytes)
+{
+	unsigned long start;
+	long i;
+	int fd;
+
+	/* connection setup and teardown */
+	start = mstime();
+	for (i = 0; i < count; i++) {
+		if ((fd = client_connect(addr, CMD_CONNECT)) < 0)
+			return 1;
+		close(fd);
+	}
+	report("connect", count, "conn", mstime() - start);
+
+	/* small message round trips */
+	if ((fd = client_connect(addr, CMD_ECHO)) < 0)
+		return 1;
+	memset(buf, 'e', MSGSIZE);
+	start = mstime();
+	for (i = 0; i < count; i++) {
+		if (write(fd, buf, MSGSIZE) != MSGSIZE || readn(fd, buf, MSGSIZE) != MSGSIZE) {
+			perror("echo");
+			close(fd);
+			return 1;
+		}
+	}
+	report("roundtrip", count, "msg", mstime() - start);
+	close(fd);
+
+	/* bulk transfer */
+	if ((fd = client_connect(addr, CMD_DISCARD)) < 0)
+		return 1;
+	memset(buf, 'd', sizeof(buf));
+	start = mstime();
+	for (i = 0; i < kbytes; i++) {
+		if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+			perror("bulk");
+			close(fd);
+			return 1;
+		}
+	}
+	report("bulk", kbytes, "KB", mstime() - start);
+	close(fd);
+	return 0;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: tcpbench -s [-p port]\n"
+			"       tcpbench [-p port] [-n count] [-k kbytes] host\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct sockaddr_in addr;
+	int ch;
+	int sflag = 0;
+	int port = DEF_PORT;
+	int count = 100;
+	int kbytes = 256;
+
+	while ((ch = getopt(argc, argv, "sp:n:k:")) != -1) {
+		switch (ch) {
+		case 's':
+			sflag = 1;
+			break;
+		case 'p':
+			port = atoi(optarg);
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'k':
+			kbytes = atoi(optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+
+	if (sflag)
+		return server(port);
+
+	if (optind >= argc)
+		usage();
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = in_aton(argv[optind]);
+	addr.sin_port = htons(port);
+	return client(&addr, count, kbytes);
+}
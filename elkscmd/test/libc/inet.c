@@ -1,5 +1,8 @@
 #include "testlib.h"
 
+#include <errno.h>
+#include <unistd.h>
+#define __LIBC__		/* get libc internal resolver cache */
 #include <arpa/inet.h>
 
 struct Test {
@@ -36,9 +39,44 @@ TEST_CASE(inet_gethostbyname)
 	a = in_gethostbyname("localhost");
 	EXPECT_STREQ(in_ntoa(a), "127.0.0.1");
 
+	/* second lookup comes from the hosts index built by the first */
+	a = in_gethostbyname("gateway");
+	EXPECT_STREQ(in_ntoa(a), "10.0.2.2");
+	a = in_gethostbyname("gateway");
+	EXPECT_STREQ(in_ntoa(a), "10.0.2.2");
+
 	/* TODO sandbox /etc/hosts? */
 }
 
+TEST_CASE(inet_rescache)
+{
+	ipaddr_t a;
+	char *file = __rescache_file;
+
+	/* test the per-process table only, leave the shared file alone */
+	__rescache_file = NULL;
+
+	__rescache_put("hit.rescache", in_aton("10.1.2.3"), 0, 60);
+	a = 0;
+	EXPECT_EQ(__rescache_get("hit.rescache", &a), 1);
+	EXPECT_STREQ(in_ntoa(a), "10.1.2.3");
+	EXPECT_EQ(__rescache_get("miss.rescache", &a), 0);
+
+	/* failed lookup returns 0 with errno set */
+	__rescache_put("neg.rescache", 0, ENONAME, 60);
+	a = 1;
+	errno = 0;
+	EXPECT_EQ(__rescache_get("neg.rescache", &a), 1);
+	EXPECT_EQ(a, 0);
+	EXPECT_EQ(errno, ENONAME);
+
+	__rescache_put("expired.rescache", in_aton("10.1.2.4"), 0, 1);
+	sleep(2);
+	EXPECT_EQ(__rescache_get("expired.rescache", &a), 0);
+
+	__rescache_file = file;
+}
+
 TEST_CASE(inet_resolv)
 {
 	/* TODO */
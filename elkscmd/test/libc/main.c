@@ -8,10 +8,13 @@
 void test_error_strerror();
 void test_inet_aton_ntoa();
 void test_inet_gethostbyname();
+void test_inet_rescache();
 void test_malloc_alloca();
 void test_malloc_calloc();
+void test_malloc_fmalloc();
 void test_malloc_malloc_free();
 void test_malloc_realloc();
+void test_malloc_small_churn();
 void test_math_abs();
 void test_math_floor();
 void test_math_pow();
@@ -22,11 +25,17 @@ void test_misc_dirname();
 void test_misc_getcwd();
 void test_misc_strtol();
 void test_regex_regcomp();
+void test_regex_dfa();
 void test_regex_expandwildcards();
+void test_stdio_bufsize();
 void test_stdio_fgets_boundary();
 void test_stdio_init();
+void test_stdio_printf_fields();
 void test_stdio_seek();
+void test_string_bench();
 void test_string_memchr();
+void test_string_memcpy();
+void test_string_memset();
 void test_string_strcat();
 void test_string_strcmp();
 void test_string_strcpy();
@@ -72,15 +81,18 @@ int main(int argc, char **argv)
 			usage(argv);
 	}
 
-	testfn_t tests[38];
+	testfn_t tests[47];
 	i = 0;
 	tests[i++] = test_error_strerror;
 	tests[i++] = test_inet_aton_ntoa;
 	tests[i++] = test_inet_gethostbyname;
+	tests[i++] = test_inet_rescache;
 	tests[i++] = test_malloc_alloca;
 	tests[i++] = test_malloc_calloc;
+	tests[i++] = test_malloc_fmalloc;
 	tests[i++] = test_malloc_malloc_free;
 	tests[i++] = test_malloc_realloc;
+	tests[i++] = test_malloc_small_churn;
 	tests[i++] = test_math_abs;
 	tests[i++] = test_math_floor;
 	tests[i++] = test_math_pow;
@@ -91,11 +103,17 @@ int main(int argc, char **argv)
 	tests[i++] = test_misc_getcwd;
 	tests[i++] = test_misc_strtol;
 	tests[i++] = test_regex_regcomp;
+	tests[i++] = test_regex_dfa;
 	tests[i++] = test_regex_expandwildcards;
+	tests[i++] = test_stdio_bufsize;
 	tests[i++] = test_stdio_fgets_boundary;
 	tests[i++] = test_stdio_init;
+	tests[i++] = test_stdio_printf_fields;
 	tests[i++] = test_stdio_seek;
+	tests[i++] = test_string_bench;
 	tests[i++] = test_string_memchr;
+	tests[i++] = test_string_memcpy;
+	tests[i++] = test_string_memset;
 	tests[i++] = test_string_strcat;
 	tests[i++] = test_string_strcmp;
 	tests[i++] = test_string_strcpy;
@@ -1,8 +1,14 @@
 #include "testlib.h"
 
 #include <errno.h>
+#include <malloc.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
+
+#define CHURN_SLOTS 64
+#define CHURN_HDR   (3 * sizeof(void *))    /* max header and rounding per block */
+#define CHURN_SLACK 64                      /* slab headers */
 
 TEST_CASE(malloc_malloc_free) {
     void *p;
@@ -79,6 +85,39 @@ TEST_CASE(malloc_realloc) {
     free(p);
 }
 
+TEST_CASE(malloc_fmalloc) {
+    char __far *p[6];
+    char __far *q;
+    unsigned int i, n;
+    int bad = 0;
+
+    /* more than a 64K data segment worth of far blocks */
+    for (i = 0; i < 6; i++) {
+        p[i] = fmalloc(20000);
+        ASSERT_TRUE(p[i] != NULL);
+        fmemset(p[i], 'a' + i, 20000);
+    }
+    for (i = 0; i < 6; i++) {
+        for (n = 0; n < 20000; n++)
+            bad |= p[i][n] != 'a' + i;
+    }
+    EXPECT_EQ(bad, 0);
+
+    /* shrink and grow keep contents */
+    q = frealloc(p[0], 100);
+    ASSERT_TRUE(q != NULL);
+    q = frealloc(q, 30000);
+    ASSERT_TRUE(q != NULL);
+    for (n = 0; n < 100; n++)
+        bad |= q[n] != 'a';
+    EXPECT_EQ(bad, 0);
+    p[0] = q;
+
+    for (i = 0; i < 6; i++)
+        ffree(p[i]);
+    EXPECT_TRUE(fmalloc(0) == NULL);
+}
+
 TEST_CASE(malloc_alloca) {
     void *p;
 
@@ -88,3 +127,60 @@ TEST_CASE(malloc_alloca) {
     /* TODO nested function calls */
     /* TODO vs setjmp / longjmp */
 }
+
+/* benchmark small string churn typical of shell and editor workloads */
+TEST_CASE(malloc_small_churn) {
+    static char *slot[CHURN_SLOTS];
+    struct timeval start, end, diff;
+    struct mallinfo mi0, mi, mi2;
+    unsigned int seed = 1;
+    unsigned int i, n, len;
+    unsigned int live = 0, nlive = 0;
+    const long iter = 8L * 1024;
+    long count = 0;
+    int bad = 0;
+
+    gettimeofday(&start, NULL);
+    mi0 = mallinfo();
+    for (long k = 0; k < iter; k++) {
+        seed = seed * 1103515245 + 12345;
+        i = (seed >> 8) % CHURN_SLOTS;
+        if (slot[i]) {
+            len = strlen(slot[i]);
+            for (n = 0; n < len; n++)
+                bad |= slot[i][n] != 'A' + (i + n) % 26;
+            free(slot[i]);
+            slot[i] = NULL;
+            live -= len + 1;
+            nlive--;
+        } else {
+            len = 1 + (seed >> 4) % 40;
+            slot[i] = malloc(len + 1);
+            ASSERT_NE_P(slot[i], NULL);
+            for (n = 0; n < len; n++)
+                slot[i][n] = 'A' + (i + n) % 26;
+            slot[i][len] = '\0';
+            live += len + 1;
+            nlive++;
+            count++;
+        }
+    }
+    mi = mallinfo();
+    gettimeofday(&end, NULL);
+    testlib_tvSub(&end, &start, &diff);
+
+    /* bytes in use grew by what is still held, plus block overhead */
+    EXPECT_EQ(bad, 0);
+    EXPECT_GE(mi.uordblks - mi0.uordblks, live);
+    EXPECT_LE(mi.uordblks - mi0.uordblks, live + nlive * CHURN_HDR + CHURN_SLACK);
+
+    /* every free puts its block back in a bin and use drops back */
+    for (i = 0; i < CHURN_SLOTS; i++)
+        free(slot[i]);
+    mi2 = mallinfo();
+    EXPECT_EQ(mi2.smblks, mi.smblks + nlive);
+    EXPECT_LE(mi2.uordblks - mi0.uordblks, CHURN_SLACK);
+
+    TEST_INFO("malloc: %ld small allocs, %ld usec, arena %u used %u\n", count,
+            diff.tv_sec * 1000000L + diff.tv_usec, mi.arena, mi.uordblks);
+}
@@ -83,6 +83,35 @@ TEST_CASE(regex_regcomp)
     free(r);
 }
 
+TEST_CASE(regex_dfa)
+{
+    static char *patterns[] = {
+        "^literal$", "a*", "a+b", "(a|b)c", "ab?c", "a.c", "[b-d]+$",
+        "^(ab|c)*d", "x[^ab]y", "$^", NULL
+    };
+    static char *strings[] = {
+        "", "literal", "not literal", "aab", "b", "bc", "ac", "abc", "abbc",
+        "axc", "xcdb", "ababcd", "xcy", "xay", NULL
+    };
+    struct regexp *r, *d;
+    int i, j;
+
+    for (i = 0; patterns[i]; i++) {
+        CAPTURE("pattern", patterns[i]);
+        r = regcomp(patterns[i]);
+        d = regcomp(patterns[i]);
+        ASSERT_NE_P(r, NULL);
+        ASSERT_NE_P(d, NULL);
+        d->regflags |= REG_DFA;
+        for (j = 0; strings[j]; j++) {
+            CAPTURE("string", strings[j]);
+            EXPECT_EQ(regexec(d, strings[j]), regexec(r, strings[j]));
+        }
+        free(r);
+        regfree(d);
+    }
+}
+
 TEST_CASE(regex_expandwildcards)
 {
     const char *root = "/tmp/libcwild";
@@ -3,6 +3,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/time.h>
 
 #define CANARY_BYTE 0x55
@@ -160,3 +161,42 @@ TEST_CASE(stdio_fgets_boundary)
 
     fclose(fp);
 }
+
+TEST_CASE(stdio_bufsize)
+{
+    FILE* fp;
+
+    /* regular files get a block sized buffer, character devices BUFSIZ */
+    fp = fopen("/tmp/libcbufsize.txt", "w");
+    ASSERT_EQ(!fp, 0);
+    EXPECT_EQ(fp->bufend - fp->bufstart, BUFSIZ_BLK);
+    fclose(fp);
+    unlink("/tmp/libcbufsize.txt");
+
+    fp = fopen("/dev/null", "w");
+    ASSERT_EQ(!fp, 0);
+    EXPECT_EQ(fp->bufend - fp->bufstart, BUFSIZ);
+    fclose(fp);
+}
+
+TEST_CASE(stdio_printf_fields)
+{
+    char buf[32];
+    int n;
+
+    /* padding, sign and literal runs are copied in bulk */
+    sprintf(buf, "[%5d|%-5d|%05d]", -42, 42, -42);
+    EXPECT_STREQ(buf, "[  -42|42   |-0042]");
+    sprintf(buf, "[%+4d|% d|%3s|%-3s|%.2s]", 7, 7, "a", "b", "xyz");
+    EXPECT_STREQ(buf, "[  +7| 7|  a|b  |xy]");
+    sprintf(buf, "%,lu %%%04x", 1234567L, 0xab);
+    EXPECT_STREQ(buf, "1,234,567 %00ab");
+
+    /* truncation in the middle of a literal run and of a padded field */
+    n = snprintf(buf, 8, "abcdefghij");
+    EXPECT_EQ(n, 10);
+    EXPECT_STREQ(buf, "abcdefg");
+    n = snprintf(buf, 6, "ab%8d", 5);
+    EXPECT_EQ(n, 10);
+    EXPECT_STREQ(buf, "ab   ");
+}
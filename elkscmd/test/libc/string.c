@@ -1,6 +1,48 @@
 #include "testlib.h"
 
 #include <string.h>
+#include <sys/time.h>
+
+/* libc/asm kernels behind memcpy and memset, chosen at startup */
+extern unsigned char __cputype;
+void *__memcpy_word(void *dest, const void *src, size_t n);
+void *__memcpy_dword(void *dest, const void *src, size_t n);
+void *__memset_word(void *s, int c, size_t n);
+void *__memset_dword(void *s, int c, size_t n);
+
+typedef void *(*copyfn_t)(void *, const void *, size_t);
+typedef void *(*setfn_t)(void *, int, size_t);
+
+static void *memcpy_byte(void *dest, const void *src, size_t n)
+{
+	char *d = dest;
+	const char *s = src;
+
+	while (n--)
+		*d++ = *s++;
+	return dest;
+}
+
+static void *memset_byte(void *s, int c, size_t n)
+{
+	char *p = s;
+
+	while (n--)
+		*p++ = c;
+	return s;
+}
+
+static struct {
+	const char *name;
+	copyfn_t copy;
+	setfn_t set;
+	unsigned char cputype;
+} variants[] = {
+	{ "byte",  memcpy_byte,    memset_byte,    0 },
+	{ "word",  __memcpy_word,  __memset_word,  0 },
+	{ "dword", __memcpy_dword, __memset_dword, 2 },
+};
+#define NVARIANTS	(sizeof(variants) / sizeof(variants[0]))
 
 TEST_CASE(string_strlen)
 {
@@ -144,6 +186,34 @@ TEST_CASE(string_strdup)
 
 TEST_CASE(string_memcpy)
 {
+	char src[48], dst[56];
+	int v, n, so, d, i, bad;
+
+	for (i = 0; i < sizeof(src); i++)
+		src[i] = i + 1;
+	EXPECT_TRUE(memcpy(dst, src, 0) == dst);
+
+	/* every alignment of both ends, lengths around the dword head/tail */
+	for (v = 0; v < NVARIANTS; v++) {
+		if (__cputype < variants[v].cputype)
+			continue;
+		bad = 0;
+		for (n = 0; n <= 40; n++) {
+			for (so = 0; so < 4; so++) {
+				for (d = 0; d < 4; d++) {
+					memset(dst, 'X', sizeof(dst));
+					if (variants[v].copy(dst + d, src + so, n) != dst + d)
+						bad++;
+					for (i = 0; i < sizeof(dst); i++) {
+						if (dst[i] != (i >= d && i < d + n ? src[so + i - d] : 'X'))
+							bad++;
+					}
+				}
+			}
+		}
+		CAPTURE("variant", variants[v].name);
+		EXPECT_EQ(bad, 0);
+	}
 }
 
 TEST_CASE(string_memccpy)
@@ -174,6 +244,62 @@ TEST_CASE(string_memchr)
 
 TEST_CASE(string_memset)
 {
+	char dst[48];
+	int v, n, d, i, bad;
+
+	for (v = 0; v < NVARIANTS; v++) {
+		if (__cputype < variants[v].cputype)
+			continue;
+		bad = 0;
+		for (n = 0; n <= 40; n++) {
+			for (d = 0; d < 4; d++) {
+				memset_byte(dst, 'X', sizeof(dst));
+				if (variants[v].set(dst + d, 0x1280 + n, n) != dst + d)
+					bad++;
+				for (i = 0; i < sizeof(dst); i++) {
+					if (dst[i] != (i >= d && i < d + n ? (char)(0x80 + n) : 'X'))
+						bad++;
+				}
+			}
+		}
+		CAPTURE("variant", variants[v].name);
+		EXPECT_EQ(bad, 0);
+	}
+}
+
+/* throughput of each kernel in bytes per 10ms clock tick */
+TEST_CASE(string_bench)
+{
+	static char a[4096], b[4096];
+	struct timeval start, end, diff;
+	const int iter = 64;
+	unsigned long bytes = (unsigned long)iter * (sizeof(a) - 1);
+	unsigned long usec;
+	int v, i;
+
+	TEST_INFO("cputype %d, %d x %u bytes\n", __cputype, iter, sizeof(a) - 1);
+	for (v = 0; v < NVARIANTS; v++) {
+		if (__cputype < variants[v].cputype)
+			continue;
+
+		gettimeofday(&start, NULL);
+		for (i = 0; i < iter; i++)
+			variants[v].copy(a + (i & 1), b, sizeof(a) - 1);
+		gettimeofday(&end, NULL);
+		testlib_tvSub(&end, &start, &diff);
+		usec = diff.tv_sec * 1000000L + diff.tv_usec;
+		TEST_INFO("memcpy %-5s %6lu bytes/tick\n", variants[v].name,
+			usec? bytes * 10000 / usec: 0);
+
+		gettimeofday(&start, NULL);
+		for (i = 0; i < iter; i++)
+			variants[v].set(a + (i & 1), i, sizeof(a) - 1);
+		gettimeofday(&end, NULL);
+		testlib_tvSub(&end, &start, &diff);
+		usec = diff.tv_sec * 1000000L + diff.tv_usec;
+		TEST_INFO("memset %-5s %6lu bytes/tick\n", variants[v].name,
+			usec? bytes * 10000 / usec: 0);
+	}
 }
 
 TEST_CASE(string_memcmp)
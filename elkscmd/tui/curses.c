@@ -3,6 +3,11 @@
  *  Part I - basic routines
  *
  * Jul 2022 Greg Haerr
+ *
+ * Output is drawn into a virtual screen of char/attribute cells and
+ * refresh() compares it against a copy of what is on the terminal,
+ * sending only changed cells with the shortest cursor motion and
+ * attribute changes, in a single write per frame.
  */
 #include "curses.h"
 #include "unikey.h"
@@ -19,18 +24,62 @@ int LINES = 25;
 int COLS = 80;
 void *stdscr;
 
+#define ATTR_PAIR       0x0F    /* cell attribute: color pair */
+#define ATTR_REVERSE    0x10    /* cell attribute: reverse video */
+#define CELL(c,a)       ((unsigned char)(c) | ((a) << 8))
+#define BLANK           CELL(' ', 0)
+#define UNKNOWN         0xFFFF  /* never matches a cell, forces redraw */
+
+static unsigned short *vscr;    /* virtual screen drawn by application */
+static unsigned short *pscr;    /* physical screen contents */
+static int cy, cx;              /* virtual cursor */
+static int py, px;              /* terminal cursor, -1 if unknown */
+static int curattr;             /* attribute for new cells */
+static int pattr;               /* terminal attribute, -1 if unknown */
+static int dirty;               /* virtual screen changed since refresh */
+static int garbaged;            /* terminal contents unknown */
+static int cursoron = 1;
+
+static char obuf[1024];         /* refresh output buffer */
+static char *op;
+
 //static int xoff, yoff;
 
+static void outmove(int y, int x);
+static void flush(void);
+
 void *initscr()
 {
     tty_init(MouseTracking|CatchISig|FullBuffer);
     if (isatty(1))
         tty_getsize(&COLS, &LINES);
+    if (!vscr) {
+        vscr = malloc(LINES * COLS * sizeof(unsigned short));
+        pscr = malloc(LINES * COLS * sizeof(unsigned short));
+        if (!vscr || !pscr) {
+            free(vscr);
+            free(pscr);
+            vscr = pscr = NULL;
+            tty_restore();
+            return NULL;
+        }
+        erase();
+    }
+    /* clear and redraw everything on first refresh */
+    garbaged = 1;
+    dirty = 0;
     return stdout;
 }
 
 void endwin()
 {
+    refresh();
+    if (!cursoron) {
+        /* leave cursor where application last moved it */
+        op = obuf;
+        outmove(cy, cx);
+        flush();
+    }
     tty_restore();
     tty_linebuffer();
 }
@@ -48,9 +97,190 @@ void nodelay(void *win, int flag)
     }
 }
 
+void start_color()
+{
+}
+
+int use_default_colors()
+{
+    return OK;
+}
+
+struct cp {
+    int fg;
+    int bg;
+};
+
+static struct cp attrs[17] = {
+    { -1, -1 },     /* entry 0 is default attribute */
+};
+
+void init_pair(int ndx, int fg, int bg)
+{
+    if (ndx >= 1 && ndx <= 16) {
+        attrs[ndx].fg = fg;
+        attrs[ndx].bg = bg;
+    }
+}
+
+/*                                  0   1   2   3   4   5   6   7
+                                   blk blu grn cyn red mag yel wht */
+static const int ansi_colors[16] = {30, 34, 32, 36, 31, 35, 33, 37,
+                                    90, 94, 92, 96, 91, 95, 93, 97 };
+
+void attron(int a)
+{
+    curattr = (curattr & ATTR_REVERSE) | (a & ATTR_PAIR);
+}
+
+void attroff(int a)
+{
+    curattr = 0;
+}
+
+/* set reverse video, used for background fill */
+void attrreverse(void)
+{
+    curattr |= ATTR_REVERSE;
+}
+
+static void flush(void)
+{
+    if (op > obuf)
+        write(1, obuf, op - obuf);
+    op = obuf;
+}
+
+static void outs(const char *s)
+{
+    while (*s) {
+        if (op >= &obuf[sizeof(obuf)])
+            flush();
+        *op++ = *s++;
+    }
+}
+
+static void outc(int c)
+{
+    if (op >= &obuf[sizeof(obuf)])
+        flush();
+    *op++ = c;
+}
+
+static void outnum(int n)
+{
+    char buf[6];
+    char *p = &buf[5];
+
+    *p = '\0';
+    do {
+        *--p = n % 10 + '0';
+    } while ((n /= 10) != 0);
+    outs(p);
+}
+
+static void outattr(int a)
+{
+    int fg = attrs[a & ATTR_PAIR].fg;
+    int bg = attrs[a & ATTR_PAIR].bg;
+
+    outs("\033[0");
+    if (a & ATTR_REVERSE)
+        outs(";7");
+    if (fg != -1) {
+        outc(';');
+        outnum(ansi_colors[fg]);
+    }
+    if (bg != -1) {
+        outc(';');
+        outnum(ansi_colors[bg] + 10);
+    }
+    outc('m');
+    pattr = a;
+}
+
+/* move terminal cursor to y,x using the fewest bytes */
+static void outmove(int y, int x)
+{
+    unsigned short *p;
+    int n;
+
+    if (y == py && x == px)
+        return;
+    if (y == py && x > px && px >= 0) {
+        n = x - px;
+        /* rewriting a few unchanged cells is cheaper than ESC [ n C */
+        if (n <= 4) {
+            p = &pscr[y * COLS + px];
+            while (n && (*p >> 8) == pattr) {
+                p++;
+                n--;
+            }
+            if (n == 0) {
+                for (p = &pscr[y * COLS + px]; px < x; px++)
+                    outc(*p++ & 0xff);
+                return;
+            }
+        }
+        outs("\033[");
+        if (x - px > 1)
+            outnum(x - px);
+        outc('C');
+    } else if (x == 0 && y == py + 1 && py >= 0) {
+        outs("\r\n");
+    } else if (x == 0 && y == py) {
+        outc('\r');
+    } else {
+        outs("\033[");
+        outnum(y + 1);
+        outc(';');
+        outnum(x + 1);
+        outc('H');
+    }
+    py = y;
+    px = x;
+}
+
 void refresh()
 {
+    unsigned short *v, *p;
+    int y, x, last;
+
     fflush(stdout);
+    if (!dirty)
+        return;
+    op = obuf;
+    if (garbaged) {
+        outs("\033[0m\033[H\033[2J");
+        for (x = 0; x < LINES * COLS; x++)
+            pscr[x] = BLANK;
+        py = px = pattr = 0;
+        garbaged = 0;
+    }
+    for (y = 0; y < LINES; y++) {
+        v = &vscr[y * COLS];
+        p = &pscr[y * COLS];
+        for (last = COLS - 1; last >= 0 && v[last] == p[last]; last--)
+            continue;
+        for (x = 0; x <= last; x++) {
+            if (v[x] == p[x])
+                continue;
+            /* don't scroll the terminal by writing the last cell */
+            if (y == LINES - 1 && x == COLS - 1)
+                break;
+            outmove(y, x);
+            if ((v[x] >> 8) != pattr)
+                outattr(v[x] >> 8);
+            outc(v[x] & 0xff);
+            p[x] = v[x];
+            if (++px >= COLS)
+                py = px = -1;   /* pending wrap, position unknown */
+        }
+    }
+    if (cursoron)
+        outmove(cy, cx);
+    flush();
+    dirty = 0;
 }
 
 void mvcur(int oy, int ox, int y, int x)
@@ -60,55 +290,134 @@ void mvcur(int oy, int ox, int y, int x)
 
 int addch(int ch)
 {
-    putchar(ch);
+    int i;
+
+    switch (ch) {
+    case '\n':
+        clrtoeol();
+        cx = 0;
+        if (cy < LINES - 1)
+            cy++;
+        return OK;
+    case '\r':
+        cx = 0;
+        return OK;
+    case '\b':
+        if (cx > 0)
+            cx--;
+        return OK;
+    case '\t':
+        i = 8 - (cx & 7);
+        while (i-- > 0)
+            addch(' ');
+        return OK;
+    }
+    if (cx >= COLS) {
+        cx = 0;
+        if (cy < LINES - 1)
+            cy++;
+    }
+    vscr[cy * COLS + cx++] = CELL(ch, curattr);
+    dirty = 1;
     return OK;
 }
 
 int mvaddch(int y, int x, int ch)
 {
-    printf("\033[%d;%dH%c", y+1, x+1, ch);
-    return OK;
+    move(y, x);
+    return addch(ch);
 }
 
 /* cursor on/off */
 void curs_set(int visibility)
 {
+    cursoron = visibility;
     printf("\033[?25%c", visibility? 'h': 'l');
 }
 
 /* clear screen */
 void erase()
 {
-    printf("\033[H\033[2J");
+    int i;
+
+    for (i = 0; i < LINES * COLS; i++)
+        vscr[i] = BLANK;
+    cy = cx = 0;
+    dirty = 1;
 }
 
 void move(int y, int x)
 {
     //y += yoff;
     //x += xoff;
-    printf("\033[%d;%dH", y+1, x+1);
+    if (y < 0)
+        y = 0;
+    else if (y >= LINES)
+        y = LINES - 1;
+    if (x < 0)
+        x = 0;
+    else if (x >= COLS)
+        x = COLS - 1;
+    cy = y;
+    cx = x;
+    dirty = 1;      /* so refresh moves the cursor */
 }
 
 void clrnl(void)
 {
-    printf("\033[0K\n");
+    addch('\n');
 }
 
 void clrtoeos(void)
 {
-    printf("\033[0J");
+    int i;
+
+    clrtoeol();
+    for (i = (cy + 1) * COLS; i < LINES * COLS; i++)
+        vscr[i] = CELL(' ', curattr);
 }
 
 void clrtoeol(void)
 {
-    printf("\033[0K");
+    int x;
+
+    for (x = cx; x < COLS; x++)
+        vscr[cy * COLS + x] = CELL(' ', curattr);
+    dirty = 1;
 }
 
 void printw(char *fmt, ...)
 {
     va_list ptr;
+    char buf[256];
+    char *p;
 
     va_start(ptr, fmt);
-    vfprintf(stdout,fmt,ptr);
+    vsnprintf(buf, sizeof(buf), fmt, ptr);
     va_end(ptr);
+    for (p = buf; *p; p++)
+        addch(*p);
+}
+
+int getcury(void *win)
+{
+    return cy;
+}
+
+/* terminal was written to directly, clear and redraw it on next refresh */
+void touchwin(void *win)
+{
+    garbaged = 1;
+    dirty = 1;
+}
+
+/* terminal line y was written to directly, redraw it on next refresh */
+void touchline(int y)
+{
+    int x;
+
+    for (x = 0; x < COLS; x++)
+        pscr[y * COLS + x] = UNKNOWN;
+    py = px = -1;
+    dirty = 1;
 }
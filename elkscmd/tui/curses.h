@@ -77,6 +77,10 @@ int getch();
 void wgetnstr(void *, char *, int);
 void attron(int a);
 void attroff(int a);
+void attrreverse(void);
+void touchline(int y);
+void touchwin(void *win);
+int getcury(void *win);
 
 void refresh();
 void mvcur(int,int,int,int);
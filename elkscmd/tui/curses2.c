@@ -41,7 +41,7 @@ int getch()
     int mx, my, modkeys, status;
     char buf[32];
 
-    fflush(stdout);
+    refresh();
     if ((n = readansi(0, buf, sizeof(buf))) < 0)
         return -1;
     if ((e = ansi_to_unikey(buf, n)) != -1) {   // FIXME UTF-8 unicode != -1
@@ -64,57 +64,17 @@ int getch()
 
 void wgetnstr(void *win, char *str, int n)
 {
+    int y = getcury(win);
+
+    refresh();
     tty_restore();
     if (fgets(str, n, stdin))
         str[strlen(str)-1] = '\0';
     else str[0] = '\0';
     tty_enable_unikey();
-}
-
-void start_color()
-{
-}
-
-int use_default_colors()
-{
-    return OK;
-}
-
-struct cp {
-    int fg;
-    int bg;
-};
-
-static struct cp attrs[17] = {
-    { -1, -1 },     /* entry 0 is default attribute */
-};
-
-void init_pair(int ndx, int fg, int bg)
-{
-    if (ndx >= 1 && ndx <= 16) {
-        attrs[ndx].fg = fg;
-        attrs[ndx].bg = bg;
-    }
-}
-
-/*                                  0   1   2   3   4   5   6   7
-                                   blk blu grn cyn red mag yel wht */
-static const int ansi_colors[16] = {30, 34, 32, 36, 31, 35, 33, 37,
-                                    90, 94, 92, 96, 91, 95, 93, 97 };
-
-void attron(int a)
-{
-    int fg = attrs[a & 0x0F].fg;
-    int bg = attrs[a & 0x0F].bg;
-
-    if (fg == -1) fg = 39; else fg = ansi_colors[fg];
-    if (bg == -1) bg = 39; else bg = ansi_colors[bg];
-    if (bg == 39)
-        printf("\033[%dm", fg);
-    else printf("\033[%d;%dm", fg, bg+10);
-}
-
-void attroff(int a)
-{
-    printf("\033[1;0;0m");
+    /* input was echoed on the cursor line followed by a newline */
+    if (y < LINES - 1) {
+        touchline(y);
+        touchline(y + 1);
+    } else touchwin(win);
 }
@@ -6,6 +6,7 @@
 
 #include "curses.h"
 #include <stdio.h>
+#include <stdarg.h>
 
 void mvwaddch(WINDOW *w, int y, int x, int ch)
 {
@@ -15,17 +16,22 @@ void mvwaddch(WINDOW *w, int y, int x, int ch)
 void mvwaddstr(WINDOW *w, int y, int x, char *str)
 {
     move(y, x);
-    printw(str);
+    while (*str)
+        addch(*str++);
 }
 
 void mvwprintw(WINDOW *w, int y, int x, char *fmt, ...)
 {
     va_list ptr;
+    char buf[256];
+    char *p;
 
     move(y, x);
     va_start(ptr, fmt);
-    vfprintf(stdout,fmt,ptr);
+    vsnprintf(buf, sizeof(buf), fmt, ptr);
     va_end(ptr);
+    for (p = buf; *p; p++)
+        addch(*p);
 }
 
 void mvwin(WINDOW *w, int y, int x)
@@ -48,11 +54,12 @@ void wattroff(WINDOW *w, int a)
 
 void wbkgdset(WINDOW *w, int a)
 {
-    printf("\033[7m");
+    attrreverse();
     attron(a);
 }
 
 void wrefresh(WINDOW *w)
 {
-    printf("\033[m");
+    attroff(0);
+    refresh();
 }
@@ -362,9 +362,9 @@ initcurses(void)
 void
 exitcurses(void)
 {
-	endwin(); /* Restore terminal */
     move(LINES - 2, 0);
     clrtoeol();
+	endwin(); /* Restore terminal */
 }
 
 /* Messages show up at the bottom */
@@ -424,7 +424,7 @@ printprompt(char *str)
 {
 	clearprompt();
 	info("%s", str);
-    fflush(stdout);
+    refresh();
 }
 
 int
@@ -948,7 +948,7 @@ nochange:
 			goto saveandbegin;
 		case SEL_HELP:
 			info(HELP);
-			fflush(stdout);
+			refresh();
 			/* Save current */
 			if (ndents > 0)
 				mkpath(path, dents[cur].name, oldpath, sizeof(oldpath));
@@ -39,6 +39,8 @@
 /*                                              by Toyoda Masashi 1992/12/11 */
 
 #include "curses.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <signal.h>
 #include <unistd.h>
 #include <time.h>
@@ -119,7 +121,10 @@ int main(int argc, char *argv[])
             option(argv[i] + 1);
         }
     }
-    initscr();
+    if (initscr() == NULL) {
+        fprintf(stderr, "sl: failed to initialize curses\n");
+        exit(1);
+    }
     signal(SIGINT, SIG_IGN);
     noecho();
     curs_set(0);
@@ -50,8 +50,10 @@ init(void)
           ttyclock.ttyscr = newterm(NULL, ftty, ftty);
           //assert(ttyclock.ttyscr != NULL);
           set_term(ttyclock.ttyscr);
-     } else
-          initscr();
+     } else if (initscr() == NULL) {
+          fprintf(stderr, "tty-clock: error: failed to initialize curses.\n");
+          exit(EXIT_FAILURE);
+     }
 
      cbreak();
      noecho();
@@ -7,7 +7,12 @@ init_curses(void)
 {
     int bg;
 
-    initscr();
+    if (initscr() == NULL)
+    {
+        fprintf(stderr, "Failed to initialize curses.\n");
+        free(pong);
+        exit(EXIT_FAILURE);
+    }
     noecho();
     nodelay(stdscr, TRUE);
     keypad(stdscr, TRUE);
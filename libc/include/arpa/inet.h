@@ -7,3 +7,9 @@ int	     in_connect(int socket, const struct sockaddr *address, socklen_t addres
 ipaddr_t in_gethostbyname(const char *str);
 char *   in_ntoa(ipaddr_t in);
 ipaddr_t in_resolv(const char *hostname, char *server);
+
+#ifdef __LIBC__
+extern char *__rescache_file;
+int	     __rescache_get(const char *name, ipaddr_t *addr);
+void	     __rescache_put(const char *name, ipaddr_t addr, int err, unsigned long ttl);
+#endif
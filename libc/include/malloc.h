@@ -17,6 +17,18 @@ void *malloc(size_t);
 void *realloc(void *, size_t);
 void *alloca(size_t);
 
+/* heap statistics, byte counts */
+struct mallinfo {
+    unsigned int arena;         /* obtained from sbrk by malloc */
+    unsigned int ordblks;       /* free chunks on chunk list */
+    unsigned int smblks;        /* free small blocks in bins */
+    unsigned int uordblks;      /* allocated */
+    unsigned int fordblks;      /* free on chunk list */
+    unsigned int fsmblks;       /* free in small bins and slab */
+};
+
+struct mallinfo mallinfo(void);
+
 #ifdef __LIBC__
 /* remove __MINI_MALLOC__ and always use real malloc for libc routines*/
 //#define __MINI_MALLOC__
@@ -31,6 +43,13 @@ extern void __wcnear *(*__alloca_alloc)(size_t);
 
 /* alloc from main memory */
 void __far *fmemalloc(unsigned long size);
+int fmemfree(void __far *ptr);
 int _fmemalloc(int paras, unsigned short *pseg);
+int _fmemfree(unsigned short seg);
+
+/* far heap sub-allocated from main memory, blocks up to 65518 bytes */
+void __far *fmalloc(size_t size);
+void ffree(void __far *ptr);
+void __far *frealloc(void __far *ptr, size_t size);
 
 #endif
@@ -15,11 +15,21 @@ typedef struct regexp {
 	char reganch;		/* Internal use only. */
 	char *regmust;		/* Internal use only. */
 	int regmlen;		/* Internal use only. */
+	char regflags;		/* REG_ flags, may be set after regcomp */
+	void *regdfa;		/* Internal use only. */
 	char program[1];	/* Unwarranted chumminess with compiler. */
 } regexp;
 
+/*
+ * With REG_DFA set in regflags, regexec matches using a lazily built DFA
+ * in a single pass without backtracking, but does not set startp and endp.
+ * Use regfree to free a regexp matched this way.
+ */
+#define REG_DFA		0x01
+
 regexp *regcomp(char *exp);
 int regexec(regexp *prog, char *string);
+void regfree(regexp *prog);
 void regerror(char *);
 
 int expandwildcards(char *name, int maxargc, char **retargv);
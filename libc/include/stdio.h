@@ -61,6 +61,7 @@ struct __stdio_file {
 typedef struct __stdio_file FILE;
 
 #define BUFSIZ  (1024)
+#define BUFSIZ_BLK (4096)       /* fopen buffer for regular files and block devices */
 
 extern FILE stdin[1];
 extern FILE stdout[1];
@@ -114,6 +115,9 @@ FILE *freopen(const char*, const char*, FILE*);
 #ifdef __LIBC__
 FILE *__fopen(const char*, int, FILE*, const char*);
 void __stdio_init(void);        /* fwd decl for OWC __LINK_SYMBOL() */
+size_t __stdio_bufsize(int fd);
+void __stdio_grow_stdout(void);
+extern unsigned char __stdio_outbuf[BUFSIZ];
 extern FILE *__IO_list;
 #endif
 
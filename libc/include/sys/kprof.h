@@ -0,0 +1,9 @@
+#ifndef __SYS_KPROF_H
+#define __SYS_KPROF_H
+
+#include <features.h>
+#include __SYSINC__(prof.h)
+
+int kprof(int op, char *buf, size_t len);
+
+#endif
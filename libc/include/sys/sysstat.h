@@ -0,0 +1,9 @@
+#ifndef __SYS_SYSSTAT_H
+#define __SYS_SYSSTAT_H
+
+#include <features.h>
+#include __SYSINC__(sysstat.h)
+
+int sysstat(int op, char *buf, size_t len);
+
+#endif
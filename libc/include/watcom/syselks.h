@@ -149,6 +149,9 @@ typedef int syscall_res;
 #define SYS_setsockopt          204
 #define SYS_getsocknam          205
 #define SYS_fmemalloc           206
+#define SYS_kprof               207
+#define SYS_sysstat             208
+#define SYS_fmemfree            209
 
 
 #define _sys_exit(rc)       sys_call1n(SYS_exit, rc)
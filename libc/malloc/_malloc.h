@@ -21,5 +21,21 @@ void __noise(char *y, mem __wcnear *x);
 #define m_size(p)  ((p) [0].size)	/* For malloc */
 
 extern mem __wcnear *__freed_list;
+extern mem __wcnear *__chunk_list;
+
+/*
+ * Small blocks are kept in bins by size class, two mem cells apart, with
+ * O(1) malloc and free and no coalescing. Empty bins are refilled by
+ * carving from a slab taken from the chunk list.
+ */
+#define SMALL_MAX   64          /* largest small block in mem cells, with header */
+#define NBINS       (SMALL_MAX/2 + 1)
+#define SLAB_SIZE   512         /* bytes per slab */
+#define m_bin(sz)   ((sz) >> 1) /* bin holding blocks of sz cells */
+
+extern mem __wcnear *__malloc_bins[NBINS];
+extern mem __wcnear *__malloc_slab;     /* next free cell in slab */
+extern mem __wcnear *__malloc_slab_end;
+extern unsigned int __malloc_arena;     /* mem cells obtained from sbrk */
 
 #endif
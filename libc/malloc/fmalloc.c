@@ -0,0 +1,192 @@
+/*
+ * Far heap: fmalloc, ffree and frealloc
+ *
+ * Blocks are sub-allocated from far arenas of main memory obtained with
+ * fmemalloc, so programs can use far more than their 64K data segment.
+ * Each block starts with a one word header holding its size in bytes
+ * including the header, with the low bit set when in use. Free blocks
+ * are found by walking an arena and joined with free neighbours as they
+ * are walked. Arenas that become completely free are returned to the
+ * kernel with fmemfree, except for the last one.
+ */
+#include <errno.h>
+#include <malloc.h>
+#include <string.h>
+
+#define _FP_SEG(fp)     ((unsigned)((unsigned long)(void __far *)(fp) >> 16))
+#define _FP_OFF(fp)     ((unsigned)(unsigned long)(void __far *)(fp))
+#define _MK_FP(seg,off) ((void __far *)((((unsigned long)(seg)) << 16) | (off)))
+
+#define ARENA_SIZE  16384U          /* default arena size */
+#define ARENA_MAX   65520U          /* largest arena, multiple of 16 */
+#define MAX_ARENAS  32
+#define FUSED       1               /* header bit: block in use */
+#define MINBLOCK    4               /* smallest block worth splitting off */
+
+#define HDR(seg,off)    (*(unsigned int __far *)_MK_FP(seg, off))
+
+static struct arena {
+    unsigned short seg;
+    unsigned int size;              /* arena size in bytes */
+    unsigned int avail;             /* free bytes, includes headers */
+} arenas[MAX_ARENAS];
+static int narenas;
+
+static struct arena *find_arena(void __far *ptr)
+{
+    struct arena *a;
+    unsigned short seg = _FP_SEG(ptr);
+
+    for (a = arenas; a < &arenas[narenas]; a++) {
+        if (a->seg == seg)
+            return a;
+    }
+    return 0;
+}
+
+static struct arena *new_arena(unsigned int need)
+{
+    struct arena *a;
+    unsigned int size = ARENA_SIZE;
+    unsigned short seg;
+
+    if (narenas >= MAX_ARENAS)
+        return 0;
+    if (need > size)
+        size = need > ARENA_MAX - 15? ARENA_MAX: (need + 15) & ~15;
+    if (_fmemalloc(size >> 4, &seg))
+        return 0;
+    a = &arenas[narenas++];
+    a->seg = seg;
+    a->size = a->avail = size;
+    HDR(seg, 0) = size;
+    return a;
+}
+
+/* join free block at off with following free blocks, return its size */
+static unsigned int join(struct arena *a, unsigned int off)
+{
+    unsigned int size = HDR(a->seg, off);
+    unsigned int next;
+
+    while ((next = off + size) < a->size && !(HDR(a->seg, next) & FUSED))
+        size += HDR(a->seg, next);
+    HDR(a->seg, off) = size;
+    return size;
+}
+
+/* mark block at off in use with size need, splitting off any excess */
+static void take(struct arena *a, unsigned int off, unsigned int size, unsigned int need)
+{
+    if (size - need >= MINBLOCK) {
+        HDR(a->seg, off + need) = size - need;
+        size = need;
+    }
+    HDR(a->seg, off) = size | FUSED;
+    a->avail -= size;
+}
+
+static void __far *arena_alloc(struct arena *a, unsigned int need)
+{
+    unsigned int off, size;
+
+    for (off = 0; off < a->size; off += size & ~FUSED) {
+        size = HDR(a->seg, off);
+        if (size & FUSED)
+            continue;
+        size = join(a, off);
+        if (size >= need) {
+            take(a, off, size, need);
+            return _MK_FP(a->seg, off + 2);
+        }
+    }
+    return 0;
+}
+
+void __far *fmalloc(size_t size)
+{
+    struct arena *a;
+    void __far *p;
+    unsigned int need;
+
+    if (size == 0)
+        return 0;
+    if (size > ARENA_MAX - 2) {
+        errno = ENOMEM;
+        return 0;
+    }
+    need = (size + 2 + 1) & ~1;
+    for (a = arenas; a < &arenas[narenas]; a++) {
+        if (a->avail >= need && (p = arena_alloc(a, need)) != 0)
+            return p;
+    }
+    if (!(a = new_arena(need))) {
+        errno = ENOMEM;
+        return 0;
+    }
+    return arena_alloc(a, need);
+}
+
+void ffree(void __far *ptr)
+{
+    struct arena *a;
+    unsigned int off = _FP_OFF(ptr) - 2;
+    unsigned int size;
+
+    if (!ptr || !(a = find_arena(ptr)))
+        return;
+    size = HDR(a->seg, off) & ~FUSED;
+    HDR(a->seg, off) = size;
+    a->avail += size;
+    if (a->avail == a->size) {
+        if (narenas > 1) {
+            _fmemfree(a->seg);
+            *a = arenas[--narenas];
+        } else
+            HDR(a->seg, 0) = a->size;
+    }
+}
+
+void __far *frealloc(void __far *ptr, size_t size)
+{
+    struct arena *a;
+    void __far *p;
+    unsigned int off, cur, need;
+
+    if (!ptr)
+        return fmalloc(size);
+    if (size == 0) {
+        ffree(ptr);
+        return 0;
+    }
+    if (!(a = find_arena(ptr)) || size > ARENA_MAX - 2)
+        return 0;
+    off = _FP_OFF(ptr) - 2;
+    cur = HDR(a->seg, off) & ~FUSED;
+    need = (size + 2 + 1) & ~1;
+
+    /* grow into following free blocks if possible */
+    if (need > cur) {
+        unsigned int next = off + cur;
+        if (next < a->size && !(HDR(a->seg, next) & FUSED)
+            && cur + join(a, next) >= need) {
+            a->avail += cur;
+            take(a, off, cur + HDR(a->seg, next), need);
+            return ptr;
+        }
+        if (!(p = fmalloc(size)))
+            return 0;
+        fmemcpy(p, ptr, cur - 2);
+        ffree(ptr);
+        return p;
+    }
+
+    /* shrink, freeing the tail */
+    if (cur - need >= MINBLOCK) {
+        HDR(a->seg, off) = need | FUSED;
+        HDR(a->seg, off + need) = cur - need;
+        a->avail += cur - need;
+        join(a, off + need);
+    }
+    return ptr;
+}
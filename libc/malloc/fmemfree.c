@@ -0,0 +1,9 @@
+#include <malloc.h>
+
+#define _FP_SEG(fp)     ((unsigned)((unsigned long)(void __far *)(fp) >> 16))
+
+/* free main memory allocated by fmemalloc */
+int fmemfree(void __far *ptr)
+{
+    return _fmemfree(_FP_SEG(ptr));
+}
@@ -13,12 +13,20 @@ free(void * ptr)
 		return;		/* free(NULL) - be nice */
 	chk--;
 
+	/* small blocks go back to their size class bin */
+	if (m_size(chk) <= SMALL_MAX) {
+		m_next(chk) = __malloc_bins[m_bin(m_size(chk))];
+		__malloc_bins[m_bin(m_size(chk))] = chk;
+		return;
+	}
+
 #ifdef __MINI_MALLOC__
  try_this:;
 #endif
 	top = (mem __wcnear *) sbrk(0);
 	if (chk + m_size(chk) == top) {
 		__noise("FREE brk", chk);
+		__malloc_arena -= m_size(chk);
 		brk(top - m_size(chk));
 		/*
 		 * Adding this code allow free to release blocks in any order; they
@@ -0,0 +1,38 @@
+#include <malloc.h>
+#include <string.h>
+
+#include "_malloc.h"
+
+struct mallinfo
+mallinfo(void)
+{
+	struct mallinfo mi;
+	mem __wcnear *p;
+	int i;
+
+	memset(&mi, 0, sizeof(mi));
+	if ((p = __chunk_list) != 0) {
+		do {
+			mi.ordblks++;
+			mi.fordblks += m_size(p);
+			p = m_next(p);
+		} while (p != __chunk_list);
+	}
+	for (p = __freed_list; p; p = m_next(p)) {
+		mi.ordblks++;
+		mi.fordblks += m_size(p);
+	}
+	for (i = 0; i < NBINS; i++) {
+		for (p = __malloc_bins[i]; p; p = m_next(p)) {
+			mi.smblks++;
+			mi.fsmblks += m_size(p);
+		}
+	}
+	mi.fsmblks += __malloc_slab_end - __malloc_slab;
+
+	mi.arena = __malloc_arena * sizeof(mem);
+	mi.fordblks *= sizeof(mem);
+	mi.fsmblks *= sizeof(mem);
+	mi.uordblks = mi.arena - mi.fordblks - mi.fsmblks;
+	return mi;
+}
@@ -7,6 +7,9 @@
  * This is a combined alloca/malloc package. It uses a classic algorithm
  * and so may be seen to be quite slow compared to more modern routines
  * with 'nasty' distributions.
+ *
+ * Small requests are served from segregated size class bins in front of
+ * the chunk list, so churning short strings never walks the list.
  */
 
 #include <malloc.h>
@@ -18,11 +21,16 @@
 #define MAX_INT ((int)(((unsigned)-1)>>1))
 
 /*
- * The chunk_list pointer is either NULL or points to a chunk in a
+ * The __chunk_list pointer is either NULL or points to a chunk in a
  * circular list of all the free blocks in memory
  */
 
-static mem __wcnear *chunk_list = 0;
+mem __wcnear *__chunk_list = 0;
+
+mem __wcnear *__malloc_bins[NBINS];
+mem __wcnear *__malloc_slab;
+mem __wcnear *__malloc_slab_end;
+unsigned int __malloc_arena;
 
 /*
  * This function takes a pointer to a block of memory and inserts it into
@@ -32,15 +40,15 @@ static void
 __insert_chunk(mem __wcnear *mem_chunk)
 {
    register mem __wcnear *p1, __wcnear *p2;
-   if (chunk_list == 0)		/* Simple case first */
+   if (__chunk_list == 0)		/* Simple case first */
    {
-      chunk_list = mem_chunk;
+      __chunk_list = mem_chunk;
       m_next(mem_chunk) = (union mem_cell __wcnear *)mem_chunk;
       __noise("FIRST CHUNK", mem_chunk);
       return;
    }
    p1 = mem_chunk;
-   p2 = chunk_list;
+   p2 = __chunk_list;
 
    do
    {
@@ -88,7 +96,7 @@ __insert_chunk(mem __wcnear *mem_chunk)
 	       m_next(p2) = m_next(p1);
 	       __noise("JOIN 3", p2);
 	    }
-	    chunk_list = p2;	/* Make sure it's valid */
+	    __chunk_list = p2;	/* Make sure it's valid */
 	    return;
 	 }
       }
@@ -102,12 +110,12 @@ __insert_chunk(mem __wcnear *mem_chunk)
 	    m_next(p2) = (union mem_cell __wcnear *)p1;
 	    __noise("INSERT CHUNK", mem_chunk);
 	    __noise("FROM", p2);
-	    chunk_list = p2;
+	    __chunk_list = p2;
 
 	    if (p1 + m_size(p1) == m_next(p1))
 	    {
 	       if (p2 == m_next(p1))
-		  chunk_list = p1;
+		  __chunk_list = p1;
 	       m_size(p1) += m_size(m_next(p1));
 	       m_next(p1) = m_next(m_next(p1));
 	       __noise("JOIN 4", p1);
@@ -115,10 +123,10 @@ __insert_chunk(mem __wcnear *mem_chunk)
 	    return;
 	 }
       }
-      chunk_list = p2;		/* Save for search */
+      __chunk_list = p2;		/* Save for search */
       p2 = m_next(p2);
    }
-   while (p2 != chunk_list);
+   while (p2 != __chunk_list);
 
    /* If we get here we have a problem, ignore it, maybe it'll go away */
    __noise("DROPPED CHUNK", mem_chunk);
@@ -133,12 +141,12 @@ static mem __wcnear *
 __search_chunk(unsigned int mem_size)
 {
    register mem __wcnear *p1, __wcnear *p2;
-   if (chunk_list == 0)		/* Simple case first */
+   if (__chunk_list == 0)		/* Simple case first */
       return 0;
 
    /* Search for a block >= the size we want */
-   p1 = m_next(chunk_list);
-   p2 = chunk_list;
+   p1 = m_next(__chunk_list);
+   p2 = __chunk_list;
    do
    {
       __noise("CHECKED", p1);
@@ -148,7 +156,7 @@ __search_chunk(unsigned int mem_size)
       p2 = p1;
       p1 = m_next(p1);
    }
-   while (p2 != chunk_list);
+   while (p2 != __chunk_list);
 
    /* None found, exit */
    if (m_size(p1) < mem_size)
@@ -158,32 +166,58 @@ __search_chunk(unsigned int mem_size)
    if (m_size(p1) < mem_size + 2)
    {
       __noise("FOUND RIGHT", p1);
-      chunk_list = m_next(p2) = m_next(p1);
-      if (chunk_list == p1)
-	 chunk_list = 0;
+      __chunk_list = m_next(p2) = m_next(p1);
+      if (__chunk_list == p1)
+	 __chunk_list = 0;
       return p1;
    }
 
    __noise("SPLIT", p1);
    /* Otherwise split it */
    m_next(p2) = (union mem_cell __wcnear *)(p1 + mem_size);
-   chunk_list = p2;
+   __chunk_list = p2;
 
    p2 = m_next(p2);
    m_size(p2) = m_size(p1) - mem_size;
    m_next(p2) = m_next(p1);
    m_size(p1) = mem_size;
-   if (chunk_list == p1)
-      chunk_list = p2;
+   if (__chunk_list == p1)
+      __chunk_list = p2;
 #ifdef VERBOSE
    p1[1].size = (unsigned int)0xAAAAAAAA;
 #endif
    __noise("INSERT CHUNK", p2);
    __noise("FOUND CHUNK", p1);
-   __noise("LIST IS", chunk_list);
+   __noise("LIST IS", __chunk_list);
    return p1;
 }
 
+/*
+ * Start a new slab for small blocks from the chunk list, after putting
+ * what is left of the current slab in its bin.
+ */
+static int
+__new_slab(void)
+{
+   register mem __wcnear *p;
+   unsigned int left;
+
+   p = (mem __wcnear *) malloc(SLAB_SIZE);
+   if (p == 0)
+      return 0;
+   left = __malloc_slab_end - __malloc_slab;
+   if (left >= 2)
+   {
+      m_size(__malloc_slab) = left;
+      m_next(__malloc_slab) = __malloc_bins[m_bin(left)];
+      __malloc_bins[m_bin(left)] = __malloc_slab;
+   }
+   __malloc_slab = p;
+   __malloc_slab_end = p + m_size(p - 1) - 1;
+   __noise("NEW SLAB", p - 1);
+   return 1;
+}
+
 void *
 malloc(size_t size)
 {
@@ -201,6 +235,25 @@ malloc(size_t size)
       sz = MINALLOC;
 #endif
 
+   if (sz <= SMALL_MAX)
+   {
+      sz = (sz + 1) & ~1;	/* round up to size class */
+      ptr = __malloc_bins[m_bin(sz)];
+      if (ptr)
+      {
+	 __malloc_bins[m_bin(sz)] = m_next(ptr);
+	 return ptr + 1;
+      }
+      if (__malloc_slab + sz <= __malloc_slab_end || __new_slab())
+      {
+	 ptr = __malloc_slab;
+	 __malloc_slab += sz;
+	 m_size(ptr) = sz;
+	 return ptr + 1;
+      }
+      /* no room for a slab, try the chunk list */
+   }
+
 #ifdef VERBOSE
    {
       static mem arr[2];
@@ -236,13 +289,13 @@ malloc(size_t size)
 
 	    __insert_chunk(ptr);
 	 }
-	 ptr = m_next(chunk_list);
+	 ptr = m_next(__chunk_list);
          if (ptr + m_size(ptr) == (void *) sbrk(0))
 	 {
 	    /* Time to free for real */
-	    m_next(chunk_list) = m_next(ptr);
+	    m_next(__chunk_list) = m_next(ptr);
 	    if (ptr == m_next(ptr))
-	       chunk_list = 0;
+	       __chunk_list = 0;
 	    free(ptr + 1);
 	 }
 #ifdef LAZY_FREE
@@ -259,7 +312,10 @@ malloc(size_t size)
          alloc = sizeof(mem) * (MCHUNK * ((sz + MCHUNK - 1) / MCHUNK) - 1);
 	 ptr = __mini_malloc(alloc);
 	 if (ptr)
+	 {
+	    __malloc_arena += m_size(ptr - 1);
 	    __insert_chunk(ptr - 1);
+	 }
 	 else		/* Oooo, near end of RAM */
 	 {
 	    unsigned int needed = alloc;
@@ -269,6 +325,7 @@ malloc(size_t size)
 	       if (ptr)
 	       {
 	          if( alloc > needed ) needed = 0; else needed -= alloc;
+	          __malloc_arena += m_size(ptr - 1);
 	          __insert_chunk(ptr - 1);
 	       }
 	       else     alloc/=2;
@@ -280,6 +337,8 @@ malloc(size_t size)
 	 {
 #ifndef MCHUNK
 	    ptr = __mini_malloc(size);
+	    if (ptr)
+	       __malloc_arena += m_size(ptr - 1);
 #endif
 #ifdef VERBOSE
 	    if( ptr == 0 )
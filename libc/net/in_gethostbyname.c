@@ -1,5 +1,9 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 /*
@@ -7,17 +11,161 @@
  *
  * Inspired by very old BSD code, Copyright (c) 1983 Regents of the University of California.
  * All rights reserved.
+ *
+ * /etc/hosts is read once into a hash index and only reread when its
+ * modification time or size changes, so repeated lookups cost a single stat.
  */
 
-/* return ip address in network byte order of host by reading /etc/hosts file*/
-ipaddr_t in_gethostbyname(const char *str)
+#define MAXHOSTS	2048	/* max /etc/hosts size to index, else scan */
+#define NHASH		16		/* hash chains, power of 2 */
+
+struct hostidx {
+	char		*name;
+	ipaddr_t	addr;
+	int			next;	/* next entry in chain or -1 */
+};
+
+static char *hostbuf;			/* file contents, names NUL terminated */
+static struct hostidx *hosts;
+static int chain[NHASH];
+static time_t hosts_mtime;
+static off_t hosts_size;
+
+static int hash(const char *name)
+{
+	unsigned int h = 0;
+
+	while (*name)
+		h += (h << 2) + *name++;
+	return h & (NHASH-1);
+}
+
+/* split a hosts line into address and names in place, return name count */
+static int parse(char *p, ipaddr_t *addr, char **names, int max)
+{
+	char *cp;
+	int n = 0;
+
+	cp = strpbrk(p, "#\n");
+	if (cp)
+		*cp = '\0';
+	cp = strpbrk(p, " \t");
+	if (cp == NULL)
+		return 0;
+	*cp++ = '\0';
+	*addr = in_aton(p);
+
+	while (*cp && n < max) {
+		if (*cp == ' ' || *cp == '\t') {
+			cp++;
+			continue;
+		}
+		names[n++] = cp;
+		cp = strpbrk(cp, " \t");
+		if (cp == NULL)
+			break;
+		*cp++ = '\0';
+	}
+	return n;
+}
+
+static void freeindex(void)
+{
+	free(hostbuf);
+	free(hosts);
+	hostbuf = NULL;
+	hosts = NULL;
+}
+
+/* build index from /etc/hosts, return 0 if file too large or no memory */
+static int buildindex(int fd, struct stat *st)
+{
+	char *p, *eol;
+	int i, h, n, count = 0, nalloc = 0;
+	ipaddr_t addr;
+	char *names[8];
+	struct hostidx *new;
+
+	freeindex();
+	if (st->st_size > MAXHOSTS || (hostbuf = malloc((size_t)st->st_size + 1)) == NULL)
+		return 0;
+	n = read(fd, hostbuf, (size_t)st->st_size);
+	if (n < 0)
+		n = 0;
+	hostbuf[n] = '\0';
+
+	for (h = 0; h < NHASH; h++)
+		chain[h] = -1;
+	for (p = hostbuf; *p; p = eol) {
+		eol = strchr(p, '\n');
+		if (eol)
+			*eol++ = '\0';
+		else
+			eol = p + strlen(p);
+		n = parse(p, &addr, names, 8);
+		for (i = 0; i < n; i++) {
+			h = hash(names[i]);
+			if (count >= nalloc) {
+				nalloc += 16;
+				new = realloc(hosts, nalloc * sizeof(struct hostidx));
+				if (new == NULL) {
+					freeindex();
+					return 0;
+				}
+				hosts = new;
+			}
+			/* append to chain so the first line naming a host wins */
+			hosts[count].name = names[i];
+			hosts[count].addr = addr;
+			hosts[count].next = -1;
+			if (chain[h] < 0)
+				chain[h] = count;
+			else {
+				int j = chain[h];
+				while (hosts[j].next >= 0)
+					j = hosts[j].next;
+				hosts[j].next = count;
+			}
+			count++;
+		}
+	}
+	hosts_mtime = st->st_mtime;
+	hosts_size = st->st_size;
+	return 1;
+}
+
+/* search /etc/hosts line by line when it couldn't be indexed */
+static ipaddr_t scan(int fd, const char *str)
 {
-	char *p, *cp;
 	FILE *fp;
-	ipaddr_t addr = 0;
-	char *name;
+	int i, n;
+	ipaddr_t addr;
+	char *names[8];
 	char buf[80];
 
+	if ((fp = fdopen(fd, "r")) == NULL) {
+		close(fd);
+		return 0;
+	}
+	while (fgets(buf, sizeof(buf), fp) != NULL) {
+		n = parse(buf, &addr, names, 8);
+		for (i = 0; i < n; i++) {
+			if (!strcmp(names[i], str)) {
+				fclose(fp);
+				return addr;
+			}
+		}
+	}
+	fclose(fp);
+	return 0;
+}
+
+/* return ip address in network byte order of host by reading /etc/hosts file*/
+ipaddr_t in_gethostbyname(const char *str)
+{
+	int fd, i;
+	struct stat st;
+
 	/* very basic check for ip address*/
 	if (*str >= '0' && *str <= '9')
 		return in_aton(str);
@@ -26,51 +174,30 @@ ipaddr_t in_gethostbyname(const char *str)
 	if (!strcmp(str, "localhost"))
 		return htonl(INADDR_LOOPBACK);
 
-	if ((fp = fopen(_PATH_HOSTS, "r")) == NULL)
+	if (stat(_PATH_HOSTS, &st) < 0) {
+		freeindex();
 		goto try_resolver;
+	}
+	if (!hostbuf || st.st_mtime != hosts_mtime || st.st_size != hosts_size) {
+		ipaddr_t addr;
 
-	while ((p = fgets(buf, sizeof(buf), fp)) != NULL) {
-		if (*p == '#')
-			continue;
-		cp = strpbrk(p, "#\n");
-		if (cp == NULL)
-			continue;
-		*cp = '\0';
-		cp = strpbrk(p, " \t");
-		if (cp == NULL)
-			continue;
-		*cp++ = '\0';
-
-		addr = in_aton(p);
-		while (*cp == ' ' || *cp == '\t')
-			cp++;
-		name = cp;
-		cp = strpbrk(cp, " \t");
-		if (cp != NULL)
-			*cp++ = '\0';
-		//printf("name %s addr %s\n", name, in_ntoa(addr));
-		if (!strcmp(name, str))
-			goto found;
-		while (cp && *cp) {
-			if (*cp == ' ' || *cp == '\t') {
-				cp++;
-				continue;
-			}
-			name = cp;
-			cp = strpbrk(cp, " \t");
-			if (cp != NULL)
-				*cp++ = '\0';
-			if (!strcmp(name, str))
-				goto found;
+		if ((fd = open(_PATH_HOSTS, O_RDONLY)) < 0)
+			goto try_resolver;
+		if (!buildindex(fd, &st)) {
+			lseek(fd, 0L, SEEK_SET);
+			if ((addr = scan(fd, str)) != 0)
+				return addr;
+			goto try_resolver;
 		}
+		close(fd);
+	}
+
+	for (i = chain[hash(str)]; i >= 0; i = hosts[i].next) {
+		if (!strcmp(hosts[i].name, str))
+			return hosts[i].addr;
 	}
 
 	/* read all of /etc/hosts, no match found*/
 try_resolver:
-	addr = in_resolv(str, NULL);
-
-found:
-	//if (addr) printf("found %s\n", name);
-	fclose(fp);
-	return addr;
+	return in_resolv(str, NULL);
 }
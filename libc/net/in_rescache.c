@@ -0,0 +1,119 @@
+/*
+ * Resolver cache
+ *
+ * Lookups are kept in a small per-process table, and in a direct-mapped
+ * table of fixed size records in _PATH_RESCACHE shared between processes,
+ * so a repeated lookup costs at most an open, seek and read instead of a
+ * nameserver connection. Failed lookups are kept too, for a shorter time.
+ *
+ * The shared file lives in a root-owned directory, is only created by
+ * root with O_EXCL, and is ignored unless it is a regular file owned by
+ * root, so other users can't plant answers. Processes that can't write
+ * it still read it and keep their own results in the per-process table.
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#define NSLOTS		32		/* shared cache entries */
+#define NLOCAL		4		/* per-process cache entries */
+
+struct rescache {
+	char		name[38];	/* NUL terminated host name */
+	short		err;		/* errno for negative entry, else 0 */
+	ipaddr_t	addr;
+	time_t		expires;
+};
+
+static struct rescache local[NLOCAL];
+
+char *__rescache_file = _PATH_RESCACHE;	/* shared cache, NULL for none */
+
+static unsigned int hash(const char *name)
+{
+	unsigned int h = 0;
+
+	while (*name)
+		h = (h << 3) + h + (*name++ | 0x20);	/* case insensitive */
+	return h;
+}
+
+/* open shared cache, return -1 unless it's a regular file owned by root */
+static int open_cache(int flags)
+{
+	int fd;
+	struct stat st;
+
+	if (!__rescache_file)
+		return -1;
+	fd = open(__rescache_file, flags);
+	if (fd < 0 && errno == ENOENT && flags != O_RDONLY)
+		fd = open(__rescache_file, flags|O_CREAT|O_EXCL, 0644);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_uid != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int valid(struct rescache *rc, const char *name, ipaddr_t *addr)
+{
+	if (strcasecmp(rc->name, name) || rc->expires <= time(NULL))
+		return 0;
+	*addr = rc->addr;
+	if (rc->err)
+		errno = rc->err;
+	return 1;
+}
+
+/* return 1 and set *addr (0 with errno set for a failed lookup) if name is cached */
+int __rescache_get(const char *name, ipaddr_t *addr)
+{
+	int fd, n;
+	unsigned int h;
+	struct rescache rc;
+
+	if (strlen(name) >= sizeof(rc.name))
+		return 0;
+	h = hash(name);
+	if (valid(&local[h % NLOCAL], name, addr))
+		return 1;
+
+	if ((fd = open_cache(O_RDONLY)) < 0)
+		return 0;
+	lseek(fd, (off_t)(h % NSLOTS) * sizeof(rc), SEEK_SET);
+	n = read(fd, &rc, sizeof(rc));
+	close(fd);
+	return n == sizeof(rc) && valid(&rc, name, addr);
+}
+
+/* remember result of a lookup for ttl seconds */
+void __rescache_put(const char *name, ipaddr_t addr, int err, unsigned long ttl)
+{
+	int fd;
+	unsigned int h;
+	struct rescache *rc;
+
+	if (strlen(name) >= sizeof(rc->name) || ttl == 0)
+		return;
+	h = hash(name);
+	rc = &local[h % NLOCAL];
+	memset(rc, 0, sizeof(*rc));
+	strcpy(rc->name, name);
+	rc->err = err;
+	rc->addr = addr;
+	rc->expires = time(NULL) + ttl;
+
+	if (geteuid() != 0 || (fd = open_cache(O_WRONLY)) < 0)
+		return;
+	lseek(fd, (off_t)(h % NSLOTS) * sizeof(*rc), SEEK_SET);
+	write(fd, rc, sizeof(*rc));
+	close(fd);
+}
@@ -17,6 +17,8 @@
 
 #define DEFAULT_DNS	"208.67.222.222"	/* DNS server IP */
 #define DNS_ENV		"DNSIP"				/* DNS server IP environment var */
+#define MAX_TTL		3600				/* max seconds to cache an answer */
+#define NEG_TTL		60					/* seconds to cache a failed lookup */
 
 /* flag codes */
 #define QUERY		0x0000	/* DNS query (opcode 0) */
@@ -81,8 +83,8 @@ static void format_dns(char *dns, const char *host)
 	*dns++ = '\0';
 }
 
-/* resolve a name to an IP address, optionally use DNS 'server' */
-ipaddr_t in_resolv(const char *hostname, char *server)
+/* query DNS 'server' for name, return IP address and its time to live */
+static ipaddr_t query(const char *hostname, char *server, unsigned long *ttl)
 {
 	int fd, rc, len;
 	struct DNS_HEADER *dns;
@@ -200,5 +202,26 @@ ipaddr_t in_resolv(const char *hostname, char *server)
 		return 0;
 	}
 
+	*ttl = ntohl(rr->ttl);
 	return rr->rdata;
 }
+
+/* resolve a name to an IP address, optionally use DNS 'server' */
+ipaddr_t in_resolv(const char *hostname, char *server)
+{
+	ipaddr_t addr;
+	unsigned long ttl;
+
+	/* explicit server requests always go to the network */
+	if (server)
+		return query(hostname, server, &ttl);
+
+	if (__rescache_get(hostname, &addr))
+		return addr;
+	addr = query(hostname, NULL, &ttl);
+	if (addr)
+		__rescache_put(hostname, addr, 0, ttl > MAX_TTL? MAX_TTL: ttl);
+	else if (errno == ENONAME)
+		__rescache_put(hostname, 0, ENONAME, NEG_TTL);
+	return addr;
+}
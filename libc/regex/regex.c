@@ -37,6 +37,7 @@
  * reganch	is the match anchored (at beginning-of-line only)?
  * regmust	string (pointer into program) that match must include, or NULL
  * regmlen	length of regmust string
+ * regdfa	DFA cache for REG_DFA matching, built by the first regexec
  *
  * Regstart and reganch permit very fast decisions on suitable starting points
  * for a match, cutting down the work a lot.  Regmust permits fast rejection
@@ -231,6 +232,8 @@ char *exp;
 	r->reganch = 0;
 	r->regmust = NULL;
 	r->regmlen = 0;
+	r->regflags = 0;
+	r->regdfa = NULL;
 	scan = r->program+1;			/* First BRANCH. */
 	if (OP(regnext(scan)) == END) {		/* Only one top-level choice. */
 		scan = OPERAND(scan);
@@ -688,6 +691,7 @@ static char **regendp;		/* Ditto for endp. */
 STATIC int regtry();
 STATIC int regmatch();
 STATIC int regrepeat();
+STATIC int regdfa();
 
 #ifdef DEBUG
 int regnarrate = 0;
@@ -729,6 +733,14 @@ register char *string;
 			return(0);
 	}
 
+	/* Match without backtracking if asked to and possible. */
+	if (prog->regflags & REG_DFA) {
+		register int ret;
+
+		if ((ret = regdfa(prog, string)) >= 0)
+			return(ret);
+	}
+
 	/* Mark beginning of line for ^ . */
 	regbol = string;
 
@@ -1049,6 +1061,378 @@ register char *p;
 		return(p+offset);
 }
 
+/*
+ - regfree - free a regexp and its DFA cache
+ */
+void
+regfree(prog)
+regexp *prog;
+{
+	if (prog != NULL) {
+		free(prog->regdfa);
+		free(prog);
+	}
+}
+
+/*
+ * Lazy DFA matching, for regexec with REG_DFA.
+ *
+ * The program is translated into a Thompson NFA, with one state per
+ * character to be matched and one for each other node.  A DFA state is
+ * the set of NFA states active after some input, and is only built the
+ * first time it is entered; it and its transitions are then cached so
+ * the common case is a table lookup per input character.  When the cache
+ * fills up it is flushed and rebuilt as needed.  Since this engine has no
+ * back references every program can be matched this way, within the
+ * DFA_NFAMAX state limit, but only success or failure is reported.
+ */
+#define	DFA_NFAMAX	255	/* Max NFA states. */
+#define	DFA_NONE	255	/* No state. */
+#define	DFA_STATES	16	/* DFA states cached. */
+
+/* NFA state types. */
+#define	N_CHAR		0	/* Match c. */
+#define	N_ANY		1	/* Match any character. */
+#define	N_ANYOF		2	/* Match any character in set. */
+#define	N_ANYBUT	3	/* Match any character not in set. */
+#define	N_SPLIT		4	/* Empty transitions to out and out1. */
+#define	N_BOL		5	/* Empty transition at beginning of line. */
+#define	N_EOL		6	/* Empty transition at end of line. */
+#define	N_MATCH		7	/* Success. */
+
+/* DFA state flags, also passed to dfaclose. */
+#define	D_MATCH		01	/* Contains N_MATCH. */
+#define	D_EOLMATCH	02	/* Contains N_MATCH at end of line. */
+#define	D_BOL		04	/* At beginning of line. */
+#define	D_EOL		010	/* At end of line. */
+
+struct nstate {
+	unsigned char type;
+	unsigned char c;
+	unsigned char out;
+	unsigned char out1;
+	char *set;
+};
+
+struct dfa {
+	struct nstate *nfa;
+	int nnfa;			/* NFA states. */
+	int first;			/* First NFA state. */
+	int match;			/* N_MATCH state. */
+	int setsize;			/* Bytes in a set of NFA states. */
+	int ndfa;			/* DFA states cached. */
+	int start;			/* Initial DFA state, -1 if not built. */
+	unsigned char *sets;		/* NFA state set of each DFA state. */
+	unsigned char *work;		/* Set being built. */
+	unsigned char *stack;		/* For dfaclose. */
+	unsigned char flags[DFA_STATES];
+	unsigned char next[DFA_STATES][256];	/* Transitions, DFA_NONE if unknown. */
+};
+
+#define	DFASET(d, i)	((d)->sets + (i) * (d)->setsize)
+#define	INSET(set, i)	((set)[(i) >> 3] & (1 << ((i) & 7)))
+
+/*
+ - regskip - return the node following p in the program text
+ */
+static char *
+regskip(p)
+register char *p;
+{
+	register int op = OP(p);
+
+	p = OPERAND(p);
+	if (op == ANYOF || op == ANYBUT || op == EXACTLY)
+		p += strlen(p) + 1;
+	return(p);
+}
+
+/*
+ - dfabuild - translate the program into an NFA and set up the DFA cache
+ */
+static struct dfa *
+dfabuild(prog)
+regexp *prog;
+{
+	register char *s;
+	register struct nstate *st;
+	register struct dfa *d;
+	unsigned char *id;
+	char *p, *next;
+	int n, size, setsize, loop, pending;
+
+	/* Number the NFA states, END is the last node emitted. */
+	n = 0;
+	for (s = prog->program + 1; OP(s) != END; s = regskip(s)) {
+		if (OP(s) == EXACTLY)
+			n += strlen(OPERAND(s));
+		else if (OP(s) == PLUS)
+			n += 2;
+		else
+			n++;
+	}
+	if (++n > DFA_NFAMAX)
+		return(NULL);
+	size = s + 3 - prog->program;
+	setsize = (n + 7) >> 3;
+	d = (struct dfa *)malloc(sizeof(struct dfa) + n * sizeof(struct nstate)
+		+ (DFA_STATES + 2) * setsize + 2 * n + 2);
+	id = (unsigned char *)malloc(size);
+	if (d == NULL || id == NULL) {
+		free(d);
+		free(id);
+		return(NULL);
+	}
+	d->nfa = (struct nstate *)(d + 1);
+	d->nnfa = n;
+	d->setsize = setsize;
+	d->sets = (unsigned char *)(d->nfa + n);
+	d->work = DFASET(d, DFA_STATES);
+	d->stack = DFASET(d, DFA_STATES + 2);
+	d->ndfa = 0;
+	d->start = -1;
+
+	n = 0;
+	for (s = prog->program + 1; ; s = regskip(s)) {
+		id[s - prog->program] = n;
+		if (OP(s) == END)
+			break;
+		n += (OP(s) == EXACTLY) ? strlen(OPERAND(s)) : (OP(s) == PLUS) ? 2 : 1;
+	}
+#define	ID(p)	((p) != NULL ? id[(p) - prog->program] : DFA_NONE)
+
+	/* Fill in the states of each node. */
+	loop = DFA_NONE;
+	for (s = prog->program + 1; ; s = regskip(s)) {
+		st = &d->nfa[id[s - prog->program]];
+		next = regnext(s);
+		st->out = ID(next);
+		st->out1 = DFA_NONE;
+		pending = loop;		/* Operand of STAR or PLUS loops back. */
+		loop = DFA_NONE;
+		switch (OP(s)) {
+		case EXACTLY:
+			for (p = OPERAND(s); *p != '\0'; p++, st++) {
+				st->type = N_CHAR;
+				st->c = *p;
+				st->out = (p[1] != '\0') ? st - d->nfa + 1 : ID(next);
+				st->out1 = DFA_NONE;
+			}
+			st--;
+			break;
+		case ANY:
+			st->type = N_ANY;
+			break;
+		case ANYOF:
+		case ANYBUT:
+			st->type = (OP(s) == ANYOF) ? N_ANYOF : N_ANYBUT;
+			st->set = OPERAND(s);
+			break;
+		case BRANCH:
+			st->type = N_SPLIT;
+			st->out = ID(OPERAND(s));
+			if (next != NULL && OP(next) == BRANCH)
+				st->out1 = ID(next);
+			break;
+		case STAR:
+			st->type = N_SPLIT;
+			st->out = ID(OPERAND(s));
+			st->out1 = ID(next);
+			loop = st - d->nfa;
+			break;
+		case PLUS:
+			st->type = N_SPLIT;
+			st->out = ID(OPERAND(s));
+			st++;
+			st->type = N_SPLIT;
+			st->out = ID(OPERAND(s));
+			st->out1 = ID(next);
+			loop = st - d->nfa;
+			break;
+		case BOL:
+			st->type = N_BOL;
+			break;
+		case EOL:
+			st->type = N_EOL;
+			break;
+		case END:
+			st->type = N_MATCH;
+			break;
+		default:		/* NOTHING, BACK, OPEN and CLOSE. */
+			st->type = N_SPLIT;
+			break;
+		}
+		if (pending != DFA_NONE)
+			st->out = pending;
+		if (OP(s) == END)
+			break;
+	}
+	d->first = id[1];
+	d->match = id[s - prog->program];
+	free(id);
+	return(d);
+}
+
+/*
+ - dfaclose - add NFA state i and all states reachable by empty transitions
+ */
+static void
+dfaclose(d, set, i, flags)
+register struct dfa *d;
+unsigned char *set;
+int i;
+int flags;
+{
+	register unsigned char *sp = d->stack;
+	register struct nstate *st;
+
+	*sp++ = i;
+	while (sp > d->stack) {
+		i = *--sp;
+		if (i == DFA_NONE || INSET(set, i))
+			continue;
+		st = &d->nfa[i];
+		if (st->type == N_BOL && !(flags & D_BOL))
+			continue;
+		set[i >> 3] |= 1 << (i & 7);
+		switch (st->type) {
+		case N_SPLIT:
+			*sp++ = st->out1;
+			/* FALLTHROUGH */
+		case N_BOL:
+			*sp++ = st->out;
+			break;
+		case N_EOL:
+			if (flags & D_EOL)
+				*sp++ = st->out;
+			break;
+		}
+	}
+}
+
+/*
+ - dfastate - find or make the DFA state for the NFA state set in work
+ */
+static int
+dfastate(d)
+register struct dfa *d;
+{
+	register int i;
+	register unsigned char *set;
+
+	for (i = 0; i < d->ndfa; i++)
+		if (memcmp(DFASET(d, i), d->work, d->setsize) == 0)
+			return(i);
+	if (d->ndfa == DFA_STATES) {	/* Flush cache. */
+		d->ndfa = 0;
+		d->start = -1;
+	}
+	i = d->ndfa++;
+	memcpy(DFASET(d, i), d->work, d->setsize);
+	memset(d->next[i], DFA_NONE, 256);
+
+	/* See if it matches now, or would at end of line. */
+	d->flags[i] = INSET(d->work, d->match) ? D_MATCH : 0;
+	set = DFASET(d, DFA_STATES + 1);
+	memset(set, 0, d->setsize);
+	for (i = 0; i < d->nnfa; i++)
+		if (INSET(d->work, i) && d->nfa[i].type == N_EOL)
+			dfaclose(d, set, i, D_EOL);
+	i = d->ndfa - 1;
+	if (INSET(set, d->match))
+		d->flags[i] |= D_EOLMATCH;
+	return(i);
+}
+
+/*
+ - dfastep - build the transition from DFA state s on character c
+ */
+static int
+dfastep(d, s, c)
+register struct dfa *d;
+int s;
+register int c;
+{
+	register struct nstate *st;
+	unsigned char *set = DFASET(d, s);
+	int i, ns;
+
+	memset(d->work, 0, d->setsize);
+	for (i = 0; i < d->nnfa; i++) {
+		if (!INSET(set, i))
+			continue;
+		st = &d->nfa[i];
+		switch (st->type) {
+		case N_CHAR:
+			if (c != st->c)
+				continue;
+			break;
+		case N_ANY:
+			break;
+		case N_ANYOF:
+			if (strchr(st->set, c) == NULL)
+				continue;
+			break;
+		case N_ANYBUT:
+			if (strchr(st->set, c) != NULL)
+				continue;
+			break;
+		default:
+			continue;
+		}
+		dfaclose(d, d->work, st->out, 0);
+	}
+	dfaclose(d, d->work, d->first, 0);	/* Unanchored, may start anywhere. */
+
+	i = d->ndfa;
+	ns = dfastate(d);
+	if (d->ndfa >= i)		/* Cache not flushed. */
+		d->next[s][c] = ns;
+	return(ns);
+}
+
+/*
+ - regdfa - match using the DFA, -1 if it can't be built
+ */
+static int
+regdfa(prog, string)
+regexp *prog;
+char *string;
+{
+	register struct dfa *d = (struct dfa *)prog->regdfa;
+	register unsigned char *s = (unsigned char *)string;
+	register int state;
+	int c, next;
+
+	if (d == NULL) {
+		if ((d = dfabuild(prog)) == NULL) {
+			prog->regflags &= ~REG_DFA;
+			return(-1);
+		}
+		prog->regdfa = d;
+	}
+	if (*s == '\0') {		/* Both beginning and end of line. */
+		memset(d->work, 0, d->setsize);
+		dfaclose(d, d->work, d->first, D_BOL|D_EOL);
+		return(INSET(d->work, d->match) != 0);
+	}
+	if (d->start < 0) {
+		memset(d->work, 0, d->setsize);
+		dfaclose(d, d->work, d->first, D_BOL);
+		d->start = dfastate(d);
+	}
+
+	state = d->start;
+	while ((c = *s++) != '\0') {
+		if (d->flags[state] & D_MATCH)
+			return(1);
+		if ((next = d->next[state][c]) == DFA_NONE)
+			next = dfastep(d, state, c);
+		state = next;
+	}
+	return((d->flags[state] & (D_MATCH|D_EOLMATCH)) != 0);
+}
+
 #ifdef DEBUG
 
 STATIC char *regprop();
@@ -12,6 +12,7 @@ __fopen(const char * fname, int fd, FILE * fp, const char * mode)
    int	 do_iosense = 1;
 #endif
    int   fopen_mode = 0;
+   size_t size;
    FILE *nfp = 0;
 
    /* If we've got an fp close the old one (freopen) */
@@ -114,7 +115,10 @@ __fopen(const char * fname, int fd, FILE * fp, const char * mode)
       }
       else
 	 fp->mode |= _IOFBF;
-      fp->bufstart = malloc(BUFSIZ);
+      size = __stdio_bufsize(fd);
+      fp->bufstart = malloc(size);
+      if (fp->bufstart == 0 && size > BUFSIZ)
+	 fp->bufstart = malloc(size = BUFSIZ);
       if (fp->bufstart == 0)	/* Oops, no mem */
       {				/* Humm, full buffering with a two(!) byte
 				 * buffer. */
@@ -123,7 +127,7 @@ __fopen(const char * fname, int fd, FILE * fp, const char * mode)
       }
       else
       {
-	 fp->bufend = fp->bufstart + BUFSIZ;
+	 fp->bufend = fp->bufstart + size;
 	 fp->mode |= __MODE_FREEBUF;
       }
    }
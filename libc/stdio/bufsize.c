@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+/*
+ * Buffer size for a stream on fd: whole disk blocks are cheap to move
+ * so regular files and block devices get a larger buffer, saving
+ * read/write system calls, while ttys, pipes and other character
+ * devices keep BUFSIZ. The larger size is only used when the heap has
+ * room for it twice over, so small heaps aren't used up by stdio.
+ */
+size_t
+__stdio_bufsize(int fd)
+{
+   struct stat st;
+   void *p;
+
+   if (fstat(fd, &st) == 0 && (S_ISREG(st.st_mode) || S_ISBLK(st.st_mode))
+       && (p = malloc(BUFSIZ_BLK * 2)) != 0)
+   {
+      free(p);
+      return BUFSIZ_BLK;
+   }
+   return BUFSIZ;
+}
+
+/*
+ * Stdout starts with its static buffer. Called by fflush the first time
+ * that buffer fills, so output that is small, or goes to a tty or pipe,
+ * never allocates.
+ */
+void
+__stdio_grow_stdout(void)
+{
+   static char tried;
+   size_t size;
+   unsigned char *buf;
+
+   if (tried || (stdout->mode & __MODE_BUF) != _IOFBF)
+      return;
+   tried = 1;
+   if ((size = __stdio_bufsize(stdout->fd)) > BUFSIZ && (buf = malloc(size)) != 0)
+   {
+      stdout->bufstart = buf;
+      stdout->bufend = buf + size;
+      stdout->mode |= __MODE_FREEBUF;
+   }
+}
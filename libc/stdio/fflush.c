@@ -67,6 +67,10 @@ fflush(FILE *fp)
 	    fp->mode |= __MODE_ERR;
 	    rv = EOF;
 	 }
+	 /* Stdout filled its static buffer, try a larger one */
+	 else if (fp == stdout && bstart == fp->bufend
+		  && fp->bufstart == __stdio_outbuf)
+	    __stdio_grow_stdout();
       }
    }
    /* If there's data in the buffer sychronise the file positions */
@@ -1,14 +1,13 @@
 #include <stdio.h>
+#include <string.h>
 
 int
 fputs(const char *str, FILE *fp)
 {
-   register int n = 0;
-   while (*str)
-   {
-      if (putc(*str++, fp) == EOF)
-	 return (EOF);
-      ++n;
-   }
+   int n = strlen(str);
+
+   /* fwrite copies in bulk and handles line buffering */
+   if (fwrite(str, 1, n, fp) != n)
+      return (EOF);
    return (n);
 }
@@ -1,15 +1,15 @@
 #include <stdio.h>
 
-static unsigned char bufout[BUFSIZ];
+unsigned char __stdio_outbuf[BUFSIZ];  /* replaced by larger buffer once filled */
 
 FILE  stdout[1] =
 {
    {
-    bufout,
-    bufout,
-    bufout,
-    bufout,
-    bufout + sizeof(bufout),
+    __stdio_outbuf,
+    __stdio_outbuf,
+    __stdio_outbuf,
+    __stdio_outbuf,
+    __stdio_outbuf + sizeof(__stdio_outbuf),
     1,
 #ifdef __WATCOMC__
     _IOLBF | __MODE_WRITE | __MODE_IOTRAN   /* FIXME flush on exit to fix */
@@ -56,6 +56,54 @@
  */
 #endif
 
+/*
+ * Copy len bytes to the stream buffer in runs rather than through putc,
+ * falling back to putc when the buffer is full or the macro can't be
+ * used (__MODE_IOTRAN). Flushes after a newline if line buffered.
+ */
+static void
+__out(FILE *op, const char *s, int len, int buffer_mode)
+{
+   int n;
+   char *nl;
+
+   while (len > 0)
+   {
+      n = op->bufwrite - op->bufpos;
+      if (n <= 0)
+      {
+         if (putc(*s, op) == EOF)
+            return;
+         if (*s++ == '\n' && buffer_mode == _IOLBF) fflush(op);
+         len--;
+         continue;
+      }
+      if (n > len)
+         n = len;
+      nl = (buffer_mode == _IOLBF)? memchr(s, '\n', n): NULL;
+      if (nl)
+         n = nl - s + 1;
+      memcpy(op->bufpos, s, n);
+      op->bufpos += n;
+      s += n;
+      len -= n;
+      if (nl) fflush(op);
+   }
+}
+
+static void
+__pad(FILE *op, char pad, int n, int buffer_mode)
+{
+   char buf[16];
+
+   memset(buf, pad, sizeof(buf));
+   while (n > 0)
+   {
+      __out(op, buf, n < sizeof(buf)? n: sizeof(buf), buffer_mode);
+      n -= sizeof(buf);
+   }
+}
+
 /*
  * Output the given field in the manner specified by the arguments. Return
  * the number of characters output.
@@ -65,7 +113,6 @@ __fmt(FILE *op, unsigned char *buf, int ljustf, int width, int preci, char pad,
     int buffer_mode)
 {
    int cnt = 0, len;
-   unsigned char ch;
 
    len = strlen((char *)buf);
 
@@ -87,35 +134,22 @@ __fmt(FILE *op, unsigned char *buf, int ljustf, int width, int preci, char pad,
    cnt = width;
    width -= len;
 
-   while (width || len)
+   if (sign && len && pad == '0')
    {
-      if (!ljustf && width)     /* left padding */
-      {
-         if (len && sign && pad == '0')
-            goto showsign;
-         ch = pad;
-         --width;
-      }
-      else if (len)
-      {
-         if (sign)
-         {
-      showsign:
-            ch = sign;          /* sign */
-            sign = '\0';
-         }
-         else
-            ch = *buf++;        /* main field */
-         --len;
-      }
-      else
-      {
-         ch = pad;              /* right padding */
-         --width;
-      }
-      putc(ch, op);
-      if( ch == '\n' && buffer_mode == _IOLBF ) fflush(op);
+      __out(op, &sign, 1, buffer_mode);     /* sign before zero padding */
+      sign = '\0';
+      --len;
+   }
+   if (!ljustf)
+      __pad(op, pad, width, buffer_mode);   /* left padding */
+   if (sign && len)
+   {
+      __out(op, &sign, 1, buffer_mode);
+      --len;
    }
+   __out(op, (char *)buf, len, buffer_mode); /* main field */
+   if (ljustf)
+      __pad(op, pad, width, buffer_mode);   /* right padding */
 
    return cnt;
 }
@@ -133,11 +167,19 @@ vfprintf(FILE *op, const char *fmt, va_list ap)
    char *p;
    int hash;
    char buf[64];
+   unsigned char obuf[80];
 
    /* turn off putc calling fputc every time for non or line buffered */
    buffer_mode = op->mode & __MODE_BUF;
    op->mode &= ~__MODE_BUF;
 
+   /* unbuffered: collect this call in obuf for a single write */
+   if (buffer_mode == _IONBF && op->bufstart == op->unbuf && op->bufpos == op->unbuf)
+   {
+      op->bufpos = op->bufwrite = op->bufstart = obuf;
+      op->bufend = obuf + sizeof(obuf);
+   }
+
    while (*fmt) {
       if (*fmt == '%') {
          ljustf = 0;            /* left justify flag */
@@ -316,18 +358,27 @@ vfprintf(FILE *op, const char *fmt, va_list ap)
 #endif
 
          default:               /* unknown character */
-            goto charout;
+            __out(op, fmt, 1, buffer_mode);
+            ++cnt;
+            break;
          }
       } else {
-       charout:
-         putc(*fmt, op);        /* normal char out */
-         if( *fmt == '\n' && buffer_mode == _IOLBF ) fflush(op);
-         ++cnt;
+         for (i = 1; fmt[i] && fmt[i] != '%'; i++)  /* literal run */
+            continue;
+         __out(op, fmt, i, buffer_mode);
+         cnt += i;
+         fmt += i;
+         continue;
       }
       ++fmt;
    }
    op->mode |= buffer_mode;
    if( buffer_mode == _IONBF ) fflush(op);
+   if (op->bufstart == obuf)
+   {
+      op->bufpos = op->bufread = op->bufwrite = op->bufstart = op->unbuf;
+      op->bufend = op->unbuf + sizeof(op->unbuf);
+   }
    if( buffer_mode == _IOLBF ) op->bufwrite = op->bufstart;
    return cnt;
 }
@@ -0,0 +1,28 @@
+#include <string.h>
+#include <asm/config.h>
+
+#ifndef LIBC_ASM_FMEMCPY
+
+void __far *fmemcpy(void __far *dest, const void __far *src, size_t l)
+{
+    char __far *d = dest;
+    const char __far *s = src;
+
+    /* copy words when both are aligned */
+    if ((((unsigned)(unsigned long)d | (unsigned)(unsigned long)s) & 1) == 0) {
+        int __far *dw = (int __far *)d;
+        const int __far *sw = (const int __far *)s;
+        size_t n;
+
+        for (n = l >> 1; n > 0; n--)
+            *dw++ = *sw++;
+        d = (char __far *)dw;
+        s = (const char __far *)sw;
+        l &= 1;
+    }
+    while (l-- > 0)
+        *d++ = *s++;
+    return dest;
+}
+
+#endif